@@ -13,6 +13,7 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -66,7 +67,7 @@ class Action {
     virtual ~Action() = default;
 
     // External read-access to particles
-    const Particles& particles() const { return particles_; }
+    std::span<const int> particles() const { return particles_; }
 
     // Abstract accept Visitor method
     virtual void accept(const AbstractActionVisitor&) const = 0;
@@ -139,7 +140,6 @@ class Remover : public AbstractActionVisitor,
       if(auto particles = action.particles(); particles.size() > 0)
       {
         std::cout << "Particle " << particles[0] << " will be removed.\n";
-        particles.erase(particles.begin());
       }
     }
 };
@@ -158,12 +158,14 @@ class Decayer : public AbstractActionVisitor,
     }
 };
 
-template<typename OPERATION>
+// Several operations can be fused into a single pass over the actions: each
+// action is loaded once and all operations are applied to it in order
+template<typename... OPERATIONS>
 void do_on_all_actions(const Actions& actions)
 {
   for (const auto& action : actions)
   {
-    action->accept( OPERATION{} );
+    ( action->accept( OPERATIONS{} ), ... );
   }
 }
 
@@ -182,4 +184,6 @@ int main() {
   do_on_all_actions<Remover>(actions);
   std::cout << "DECAY:\n";
   do_on_all_actions<Decayer>(actions);
+  std::cout << "ALL IN ONE PASS:\n";
+  do_on_all_actions<Performer, Remover, Decayer>(actions);
 }
@@ -0,0 +1,266 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Same acyclic visitor as in 06_classic_acyclic_visitor.cpp, with an
+ * additional batched mode to reduce the cost of the dynamic_cast.
+ *
+ *  1) Actions are grouped by their dynamic type once (ActionGroups)
+ *      ↳ a group can be reused for as many operations as needed, as long as
+ *        the underlying actions are not changed.
+ *  2) Each group is visited as a whole (Action::accept_group)
+ *      ↳ the dynamic_cast to the visitor capability is done once per group;
+ *      ↳ the typed visit is then called in a tight loop over the group;
+ *      ↳ a group the visitor cannot handle is skipped as a block.
+ *  3) The price to pay
+ *      ↳ actions of different types are not visited in the original order
+ *        anymore, but group by group, in order of first appearance.
+ */
+
+// Taken from https://stackoverflow.com/a/56766138/14967071
+template <typename T>
+constexpr auto type_name() {
+  std::string_view name, prefix, suffix;
+#ifdef __clang__
+  name = __PRETTY_FUNCTION__;
+  prefix = "auto type_name() [T = ";
+  suffix = "]";
+#elif defined(__GNUC__)
+  name = __PRETTY_FUNCTION__;
+  prefix = "constexpr auto type_name() [with T = ";
+  suffix = "]";
+#elif defined(_MSC_VER)
+  name = __FUNCSIG__;
+  prefix = "auto __cdecl type_name<";
+  suffix = ">(void)";
+#endif
+  name.remove_prefix(prefix.size());
+  name.remove_suffix(suffix.size());
+  return name;
+}
+
+class Action;
+using ActionGroup = std::span<const Action* const>;
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class AbstractActionVisitor {
+  public:
+    virtual ~AbstractActionVisitor() = default;
+};
+
+template<typename T>
+class ActionVisitor {
+  public:
+    virtual ~ActionVisitor() = default;
+    virtual void visit(const T&) const = 0;
+};
+
+class Action {
+  public:
+    // Rule of 5: Action cannot be copied or moved
+    Action(Particles p) : particles_{std::move(p)} {};
+    Action(const Action &) = delete;
+    Action& operator=(const Action &) = delete;
+    Action(Action &&) = delete;
+    Action& operator=(Action &&) = delete;
+    // Virtual destructor for polymorphism
+    virtual ~Action() = default;
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+    // Abstract accept Visitor method
+    virtual void accept(const AbstractActionVisitor&) const = 0;
+    // Abstract accept Visitor method for a group of actions, all having the
+    // same dynamic type as this one
+    virtual void accept_group(const AbstractActionVisitor&, ActionGroup) const = 0;
+
+  private:
+    Particles particles_;
+};
+
+template<typename T>
+void accept_group_as(const AbstractActionVisitor& visitor, ActionGroup group)
+{
+  if (auto concrete_visitor = dynamic_cast<const ActionVisitor<T>*>(&visitor)){
+    for (const Action* action : group)
+    {
+      concrete_visitor->visit(static_cast<const T&>(*action));
+    }
+  } else {
+    std::cout << type_name<T>() << ": " << group.size() << " action(s) cannot be visited.\n";
+  }
+}
+
+class ScatterAction : public Action {
+  public:
+    ScatterAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if (auto concrete_visitor = dynamic_cast<const ActionVisitor<ScatterAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "ScatterAction: I cannot be visited.\n";
+      }
+    }
+
+    void accept_group(const AbstractActionVisitor& visitor, ActionGroup group) const override {
+      accept_group_as<ScatterAction>(visitor, group);
+    }
+};
+
+class FluidizationAction : public Action {
+  public:
+    FluidizationAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if(auto concrete_visitor = dynamic_cast<const ActionVisitor<FluidizationAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "FluidizationAction: I cannot be visited.\n";
+      }
+    }
+
+    void accept_group(const AbstractActionVisitor& visitor, ActionGroup group) const override {
+      accept_group_as<FluidizationAction>(visitor, group);
+    }
+};
+
+class DecayAction : public Action {
+  public:
+    DecayAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if(auto concrete_visitor = dynamic_cast<const ActionVisitor<DecayAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "DecayAction: I cannot be visited.\n";
+      }
+    }
+
+    void accept_group(const AbstractActionVisitor& visitor, ActionGroup group) const override {
+      accept_group_as<DecayAction>(visitor, group);
+    }
+};
+
+class Performer : public AbstractActionVisitor,
+                  public ActionVisitor<ScatterAction>,
+                  public ActionVisitor<FluidizationAction> {
+  public:
+    void visit(const ScatterAction& action) const override {
+      if(auto particles = action.particles(); particles.size() > 1){
+        std::cout << "Scattering between " << particles[0] << " and " << particles[1] << ".\n";
+      }
+    }
+    void visit(const FluidizationAction& action) const override {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles.back() << " will be melt.\n";
+      }
+    }
+};
+
+// Let's add a new operation for FluidizationAction only
+class Remover : public AbstractActionVisitor,
+                public ActionVisitor<FluidizationAction> {
+  public:
+    void visit(const FluidizationAction& action) const override {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles[0] << " will be removed.\n";
+      }
+    }
+};
+
+// Let's add another new operation for DecayAction only
+class Decayer : public AbstractActionVisitor,
+                public ActionVisitor<DecayAction> {
+  public:
+    void visit(const DecayAction& action) const override {
+      std::cout << "Particle(s) ";
+      for(auto p : action.particles())
+      {
+        std::cout << p << " ";
+      }
+      std::cout << "will be decayed.\n";
+    }
+};
+
+template<typename OPERATION>
+void do_on_all_actions(const Actions& actions)
+{
+  for (const auto& action : actions)
+  {
+    action->accept( OPERATION{} );
+  }
+}
+
+// Actions grouped by dynamic type, in order of first appearance
+class ActionGroups {
+  public:
+    explicit ActionGroups(const Actions& actions) {
+      std::unordered_map<std::type_index, std::size_t> group_of_type{};
+      for (const auto& action : actions)
+      {
+        auto [it, is_new_type] = group_of_type.try_emplace(typeid(*action), groups_.size());
+        if (is_new_type) {
+          groups_.emplace_back();
+        }
+        groups_[it->second].push_back(action.get());
+      }
+    }
+
+    auto begin() const { return groups_.begin(); }
+    auto end() const { return groups_.end(); }
+
+  private:
+    std::vector<std::vector<const Action*>> groups_{};
+};
+
+template<typename OPERATION>
+void do_on_all_actions(const ActionGroups& groups)
+{
+  const OPERATION operation{};
+  for (const auto& group : groups)
+  {
+    group.front()->accept_group(operation, group);
+  }
+}
+
+int main() {
+  // Creating actions
+  Particles p1 = {1, 11, 111}, p2 = {42, 666, 13}, p3 = {66, 77};
+  Actions actions{};
+  actions.emplace_back(std::make_unique<ScatterAction>(std::move(p1)));
+  actions.emplace_back(std::make_unique<FluidizationAction>(std::move(p2)));
+  actions.emplace_back(std::make_unique<DecayAction>(std::move(p3)));
+
+  // Performing actions, grouping them by type only once
+  const ActionGroups groups{actions};
+  std::cout << "PERFORM:\n";
+  do_on_all_actions<Performer>(groups);
+  std::cout << "REMOVAL:\n";
+  do_on_all_actions<Remover>(groups);
+  std::cout << "DECAY:\n";
+  do_on_all_actions<Decayer>(groups);
+}
@@ -0,0 +1,247 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Same acyclic visitor as in 06_classic_acyclic_visitor.cpp, but the
+ * container keeps an index of its actions per type.
+ *
+ *  1) IndexedActions<ActionTypes...> owns all actions, as Actions does
+ *      ↳ in addition, for each type, it keeps a list of the actions of that
+ *        type, filled when the action is added.
+ *  2) Which types a visitor handles is known at compile time
+ *      ↳ it derives from ActionVisitor<T> for each of them;
+ *      ↳ do_on_all_actions only walks the lists of those types, hence a
+ *        visitor handling rare actions costs O(#rare actions);
+ *      ↳ neither dynamic_cast nor accept is needed on this path and, if the
+ *        visitor is final, the visit call can be devirtualized.
+ *  3) The price to pay
+ *      ↳ actions of different types are visited type by type, not in the
+ *        order in which they were added;
+ *      ↳ all action types must be listed in the container type.
+ */
+
+class Action;
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class AbstractActionVisitor {
+  public:
+    virtual ~AbstractActionVisitor() = default;
+};
+
+template<typename T>
+class ActionVisitor {
+  public:
+    virtual ~ActionVisitor() = default;
+    virtual void visit(const T&) const = 0;
+};
+
+class Action {
+  public:
+    // Rule of 5: Action cannot be copied or moved
+    Action(Particles p) : particles_{std::move(p)} {};
+    Action(const Action &) = delete;
+    Action& operator=(const Action &) = delete;
+    Action(Action &&) = delete;
+    Action& operator=(Action &&) = delete;
+    // Virtual destructor for polymorphism
+    virtual ~Action() = default;
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+    // Abstract accept Visitor method
+    virtual void accept(const AbstractActionVisitor&) const = 0;
+
+  private:
+    Particles particles_;
+};
+
+class ScatterAction : public Action {
+  public:
+    ScatterAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if (auto concrete_visitor = dynamic_cast<const ActionVisitor<ScatterAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "ScatterAction: I cannot be visited.\n";
+      }
+    }
+};
+
+class FluidizationAction : public Action {
+  public:
+    FluidizationAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if(auto concrete_visitor = dynamic_cast<const ActionVisitor<FluidizationAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "FluidizationAction: I cannot be visited.\n";
+      }
+    }
+};
+
+class DecayAction : public Action {
+  public:
+    DecayAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if(auto concrete_visitor = dynamic_cast<const ActionVisitor<DecayAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "DecayAction: I cannot be visited.\n";
+      }
+    }
+};
+
+template<typename... ActionTypes>
+class IndexedActions {
+    static_assert((std::is_base_of_v<Action, ActionTypes> && ...),
+                  "IndexedActions can only index types derived from Action");
+
+  public:
+    template<typename T, typename... Args>
+    T& emplace_back(Args&&... args) {
+      auto action = std::make_unique<T>(std::forward<Args>(args)...);
+      T& reference = *action;
+      // Owned first, so that the index never refers to a freed action
+      actions_.push_back(std::move(action));
+      try {
+        std::get<std::vector<const T*>>(index_).push_back(&reference);
+      } catch (...) {
+        actions_.pop_back();
+        throw;
+      }
+      return reference;
+    }
+
+    // All actions, in the order in which they were added
+    const Actions& all() const { return actions_; }
+
+    // Only the actions of type T, in the order in which they were added
+    template<typename T>
+    std::span<const T* const> of_type() const {
+      return std::get<std::vector<const T*>>(index_);
+    }
+
+    std::size_t size() const { return actions_.size(); }
+
+  private:
+    Actions actions_{};
+    std::tuple<std::vector<const ActionTypes*>...> index_{};
+};
+
+using ActionsByType = IndexedActions<ScatterAction, FluidizationAction, DecayAction>;
+
+class Performer final : public AbstractActionVisitor,
+                        public ActionVisitor<ScatterAction>,
+                        public ActionVisitor<FluidizationAction> {
+  public:
+    void visit(const ScatterAction& action) const override {
+      if(auto particles = action.particles(); particles.size() > 1){
+        std::cout << "Scattering between " << particles[0] << " and " << particles[1] << ".\n";
+      }
+    }
+    void visit(const FluidizationAction& action) const override {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles.back() << " will be melt.\n";
+      }
+    }
+};
+
+// Let's add a new operation for FluidizationAction only
+class Remover final : public AbstractActionVisitor,
+                      public ActionVisitor<FluidizationAction> {
+  public:
+    void visit(const FluidizationAction& action) const override {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles[0] << " will be removed.\n";
+      }
+    }
+};
+
+// Let's add another new operation for DecayAction only
+class Decayer final : public AbstractActionVisitor,
+                      public ActionVisitor<DecayAction> {
+  public:
+    void visit(const DecayAction& action) const override {
+      std::cout << "Particle(s) ";
+      for(auto p : action.particles())
+      {
+        std::cout << p << " ";
+      }
+      std::cout << "will be decayed.\n";
+    }
+};
+
+// Generic path, every action is visited through accept
+template<typename OPERATION>
+void do_on_all_actions(const Actions& actions)
+{
+  for (const auto& action : actions)
+  {
+    action->accept( OPERATION{} );
+  }
+}
+
+// Indexed path, lists of actions the operation cannot visit are not touched
+template<typename T, typename OPERATION>
+void visit_all_of_type(const OPERATION& operation, std::span<const T* const> group)
+{
+  if constexpr (std::is_base_of_v<ActionVisitor<T>, OPERATION>) {
+    for (const T* action : group)
+    {
+      operation.visit(*action);
+    }
+  }
+}
+
+template<typename OPERATION, typename... ActionTypes>
+void do_on_all_actions(const IndexedActions<ActionTypes...>& actions)
+{
+  const OPERATION operation{};
+  ( visit_all_of_type<ActionTypes>(operation, actions.template of_type<ActionTypes>()), ... );
+}
+
+int main() {
+  // Creating actions
+  ActionsByType actions{};
+  actions.emplace_back<ScatterAction>(Particles{1, 11, 111});
+  actions.emplace_back<FluidizationAction>(Particles{42, 666, 13});
+  actions.emplace_back<DecayAction>(Particles{66, 77});
+  actions.emplace_back<ScatterAction>(Particles{2, 22});
+
+  // Performing actions, only the relevant ones are visited
+  std::cout << "PERFORM:\n";
+  do_on_all_actions<Performer>(actions);
+  std::cout << "REMOVAL:\n";
+  do_on_all_actions<Remover>(actions);
+  std::cout << "DECAY (" << actions.of_type<DecayAction>().size() << " out of "
+            << actions.size() << " actions visited):\n";
+  do_on_all_actions<Decayer>(actions);
+
+  // The generic path is still available, in the original order
+  std::cout << "DECAY (all actions visited):\n";
+  do_on_all_actions<Decayer>(actions.all());
+}
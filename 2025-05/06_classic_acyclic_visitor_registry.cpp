@@ -0,0 +1,240 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+
+/*
+ * Same acyclic visitor as in 06_classic_acyclic_visitor.cpp, without any
+ * dynamic_cast. This compiles with -fno-rtti, too.
+ *
+ *  1) Each action type gets a dense integer id on first use
+ *      ↳ ids are handed out by ActionTypeRegistry, which does not need to
+ *        know all action types in advance (the visitor stays acyclic).
+ *  2) Each visitor publishes a table of "thunks", indexed by action type id
+ *      ↳ a thunk is a plain function pointer that casts visitor and action
+ *        back to their static types and calls the right visit;
+ *      ↳ the table is built once per visitor type, listing the action types
+ *        it can handle (see VisitorOf), and it is nullptr elsewhere.
+ *  3) Action::accept is not virtual anymore
+ *      ↳ one bounds check, one array load and one indirect call, no matter
+ *        how many action types and visitors exist.
+ */
+
+// Taken from https://stackoverflow.com/a/56766138/14967071
+template <typename T>
+constexpr auto type_name() {
+  std::string_view name, prefix, suffix;
+#ifdef __clang__
+  name = __PRETTY_FUNCTION__;
+  prefix = "auto type_name() [T = ";
+  suffix = "]";
+#elif defined(__GNUC__)
+  name = __PRETTY_FUNCTION__;
+  prefix = "constexpr auto type_name() [with T = ";
+  suffix = "]";
+#elif defined(_MSC_VER)
+  name = __FUNCSIG__;
+  prefix = "auto __cdecl type_name<";
+  suffix = ">(void)";
+#endif
+  name.remove_prefix(prefix.size());
+  name.remove_suffix(suffix.size());
+  return name;
+}
+
+class Action;
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+using ActionTypeId = std::size_t;
+
+class ActionTypeRegistry {
+  public:
+    // Dense id of the action type T, assigned the first time it is asked for
+    template<typename T>
+    static ActionTypeId id() {
+      static const ActionTypeId id = register_type(type_name<T>());
+      return id;
+    }
+
+    static std::string_view name(ActionTypeId id) {
+      std::lock_guard lock{mutex_};
+      return names_[id];
+    }
+
+  private:
+    static ActionTypeId register_type(std::string_view name) {
+      std::lock_guard lock{mutex_};
+      names_.push_back(name);
+      return names_.size() - 1;
+    }
+
+    inline static std::mutex mutex_{};
+    inline static std::vector<std::string_view> names_{};
+};
+
+class AbstractActionVisitor {
+  public:
+    using Thunk = void (*)(const AbstractActionVisitor&, const Action&);
+
+    Thunk thunk_for(ActionTypeId id) const {
+      return id < table_.size() ? table_[id] : nullptr;
+    }
+
+  protected:
+    explicit AbstractActionVisitor(std::span<const Thunk> table) : table_{table} {}
+    ~AbstractActionVisitor() = default;
+
+  private:
+    std::span<const Thunk> table_;
+};
+
+class Action {
+  public:
+    // Rule of 5: Action cannot be copied or moved
+    Action(ActionTypeId id, Particles p) : type_id_{id}, particles_{std::move(p)} {};
+    Action(const Action &) = delete;
+    Action& operator=(const Action &) = delete;
+    Action(Action &&) = delete;
+    Action& operator=(Action &&) = delete;
+    // Virtual destructor for polymorphism
+    virtual ~Action() = default;
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+    // Accept Visitor method, resolved through the visitor table
+    void accept(const AbstractActionVisitor& visitor) const {
+      if (auto thunk = visitor.thunk_for(type_id_)) {
+        thunk(visitor, *this);
+      } else {
+        std::cout << ActionTypeRegistry::name(type_id_) << ": I cannot be visited.\n";
+      }
+    }
+
+  private:
+    ActionTypeId type_id_;
+    Particles particles_;
+};
+
+class ScatterAction : public Action {
+  public:
+    ScatterAction(Particles p) : Action{ActionTypeRegistry::id<ScatterAction>(), std::move(p)} {}
+};
+
+class FluidizationAction : public Action {
+  public:
+    FluidizationAction(Particles p) : Action{ActionTypeRegistry::id<FluidizationAction>(), std::move(p)} {}
+};
+
+class DecayAction : public Action {
+  public:
+    DecayAction(Particles p) : Action{ActionTypeRegistry::id<DecayAction>(), std::move(p)} {}
+};
+
+// CRTP base publishing the thunk table of VISITOR for the given action types
+template<typename VISITOR, typename... ActionTypes>
+class VisitorOf : public AbstractActionVisitor {
+  public:
+    VisitorOf() : AbstractActionVisitor{table()} {}
+
+  private:
+    static std::span<const Thunk> table() {
+      static const std::vector<Thunk> thunks = [] {
+        std::vector<Thunk> t{};
+        (add_thunk<ActionTypes>(t), ...);
+        return t;
+      }();
+      return thunks;
+    }
+
+    template<typename T>
+    static void add_thunk(std::vector<Thunk>& t) {
+      const auto id = ActionTypeRegistry::id<T>();
+      if (t.size() <= id) {
+        t.resize(id + 1, nullptr);
+      }
+      t[id] = [](const AbstractActionVisitor& visitor, const Action& action) {
+        static_cast<const VISITOR&>(visitor).visit(static_cast<const T&>(action));
+      };
+    }
+};
+
+class Performer : public VisitorOf<Performer, ScatterAction, FluidizationAction> {
+  public:
+    void visit(const ScatterAction& action) const {
+      if(const auto& particles = action.particles(); particles.size() > 1){
+        std::cout << "Scattering between " << particles[0] << " and " << particles[1] << ".\n";
+      }
+    }
+    void visit(const FluidizationAction& action) const {
+      if(const auto& particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles.back() << " will be melt.\n";
+      }
+    }
+};
+
+// Let's add a new operation for FluidizationAction only
+class Remover : public VisitorOf<Remover, FluidizationAction> {
+  public:
+    void visit(const FluidizationAction& action) const {
+      if(const auto& particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles[0] << " will be removed.\n";
+      }
+    }
+};
+
+// Let's add another new operation for DecayAction only
+class Decayer : public VisitorOf<Decayer, DecayAction> {
+  public:
+    void visit(const DecayAction& action) const {
+      std::cout << "Particle(s) ";
+      for(auto p : action.particles())
+      {
+        std::cout << p << " ";
+      }
+      std::cout << "will be decayed.\n";
+    }
+};
+
+template<typename OPERATION>
+void do_on_all_actions(const Actions& actions)
+{
+  const OPERATION operation{};
+  for (const auto& action : actions)
+  {
+    action->accept( operation );
+  }
+}
+
+int main() {
+  // Creating actions
+  Particles p1 = {1, 11, 111}, p2 = {42, 666, 13}, p3 = {66, 77};
+  Actions actions{};
+  actions.emplace_back(std::make_unique<ScatterAction>(std::move(p1)));
+  actions.emplace_back(std::make_unique<FluidizationAction>(std::move(p2)));
+  actions.emplace_back(std::make_unique<DecayAction>(std::move(p3)));
+
+  // Performing actions
+  std::cout << "PERFORM:\n";
+  do_on_all_actions<Performer>(actions);
+  std::cout << "REMOVAL:\n";
+  do_on_all_actions<Remover>(actions);
+  std::cout << "DECAY:\n";
+  do_on_all_actions<Decayer>(actions);
+}
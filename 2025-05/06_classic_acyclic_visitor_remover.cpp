@@ -0,0 +1,290 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * Same acyclic visitor as in 06_classic_acyclic_visitor.cpp, where the
+ * Remover really removes particles from the actions.
+ *
+ *  1) During the pass, removals are only recorded as tombstones
+ *      ↳ actions are not changed while being visited, hence visit() can
+ *        still take a const reference to them.
+ *  2) At the end of the pass, all tombstones are applied at once
+ *      ↳ do_on_all_actions calls finalize(actions) on the operation, if the
+ *        operation provides it;
+ *      ↳ tombstones can be recorded in any order, they are sorted by action
+ *        and position, so that those of each action are found by a binary
+ *        search and are already sorted;
+ *      ↳ each action compacts its particles in one pass, skipping the
+ *        removed positions.
+ *     Apart from sorting the tombstones, the cost is linear in the total
+ *     number of particles, while erasing the particles one by one would be
+ *     quadratic per action.
+ */
+
+// Taken from https://stackoverflow.com/a/56766138/14967071
+template <typename T>
+constexpr auto type_name() {
+  std::string_view name, prefix, suffix;
+#ifdef __clang__
+  name = __PRETTY_FUNCTION__;
+  prefix = "auto type_name() [T = ";
+  suffix = "]";
+#elif defined(__GNUC__)
+  name = __PRETTY_FUNCTION__;
+  prefix = "constexpr auto type_name() [with T = ";
+  suffix = "]";
+#elif defined(_MSC_VER)
+  name = __FUNCSIG__;
+  prefix = "auto __cdecl type_name<";
+  suffix = ">(void)";
+#endif
+  name.remove_prefix(prefix.size());
+  name.remove_suffix(suffix.size());
+  return name;
+}
+
+class Action;
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class AbstractActionVisitor {
+  public:
+    virtual ~AbstractActionVisitor() = default;
+};
+
+template<typename T>
+class ActionVisitor {
+  public:
+    virtual ~ActionVisitor() = default;
+    virtual void visit(const T&) const = 0;
+};
+
+class Action {
+  public:
+    // Rule of 5: Action cannot be copied or moved
+    Action(Particles p) : particles_{std::move(p)} {};
+    Action(const Action &) = delete;
+    Action& operator=(const Action &) = delete;
+    Action(Action &&) = delete;
+    Action& operator=(Action &&) = delete;
+    // Virtual destructor for polymorphism
+    virtual ~Action() = default;
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+    // Remove the particles at the given positions, which must be sorted and unique
+    void remove_particles(std::span<const std::size_t> positions) {
+      auto next_removed = positions.begin();
+      std::size_t kept = 0;
+      for (std::size_t i = 0; i < particles_.size(); ++i) {
+        if (next_removed != positions.end() && *next_removed == i) {
+          ++next_removed;
+        } else {
+          particles_[kept++] = particles_[i];
+        }
+      }
+      particles_.resize(kept);
+    }
+
+    // Abstract accept Visitor method
+    virtual void accept(const AbstractActionVisitor&) const = 0;
+
+  private:
+    Particles particles_;
+};
+
+class ScatterAction : public Action {
+  public:
+    ScatterAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if (auto concrete_visitor = dynamic_cast<const ActionVisitor<ScatterAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "ScatterAction: I cannot be visited.\n";
+      }
+    }
+};
+
+class FluidizationAction : public Action {
+  public:
+    FluidizationAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if(auto concrete_visitor = dynamic_cast<const ActionVisitor<FluidizationAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "FluidizationAction: I cannot be visited.\n";
+      }
+    }
+};
+
+class DecayAction : public Action {
+  public:
+    DecayAction(Particles p) : Action{std::move(p)} {}
+
+    void accept(const AbstractActionVisitor& visitor) const override {
+      if(auto concrete_visitor = dynamic_cast<const ActionVisitor<DecayAction>*>(&visitor)){
+        concrete_visitor->visit(*this);
+      } else {
+        std::cout << "DecayAction: I cannot be visited.\n";
+      }
+    }
+};
+
+class Performer : public AbstractActionVisitor,
+                  public ActionVisitor<ScatterAction>,
+                  public ActionVisitor<FluidizationAction> {
+  public:
+    void visit(const ScatterAction& action) const override {
+      if(auto particles = action.particles(); particles.size() > 1){
+        std::cout << "Scattering between " << particles[0] << " and " << particles[1] << ".\n";
+      }
+    }
+    void visit(const FluidizationAction& action) const override {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles.back() << " will be melt.\n";
+      }
+    }
+};
+
+// Particles to be removed from actions, recorded in the order of the actions
+class Tombstones {
+  public:
+    void mark(const Action& action, std::size_t position) {
+      marks_.push_back({&action, position});
+    }
+
+    // Remove all marked particles and forget about them
+    void apply(Actions& actions) {
+      // Pointers to different actions are ordered by std::less only
+      constexpr std::less<const Action*> before{};
+      std::sort(marks_.begin(), marks_.end(), [before](const Mark& a, const Mark& b) {
+        return before(a.action, b.action) ||
+               (a.action == b.action && a.position < b.position);
+      });
+      for (auto& action : actions)
+      {
+        auto first = std::lower_bound(
+            marks_.begin(), marks_.end(), action.get(),
+            [before](const Mark& mark, const Action* a) { return before(mark.action, a); });
+        positions_.clear();
+        for (; first != marks_.end() && first->action == action.get(); ++first) {
+          if (positions_.empty() || positions_.back() != first->position) {
+            positions_.push_back(first->position);
+          }
+        }
+        if (!positions_.empty()) {
+          action->remove_particles(positions_);
+        }
+      }
+      marks_.clear();
+      positions_.clear();
+    }
+
+  private:
+    struct Mark {
+        const Action* action;
+        std::size_t position;
+    };
+
+    std::vector<Mark> marks_{};
+    // Sorted and unique positions of one action, reused
+    std::vector<std::size_t> positions_{};
+};
+
+// Let's add a new operation for FluidizationAction only
+class Remover : public AbstractActionVisitor,
+                public ActionVisitor<FluidizationAction> {
+  public:
+    void visit(const FluidizationAction& action) const override {
+      if(const auto& particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles[0] << " will be removed.\n";
+        tombstones_.mark(action, 0);
+      }
+    }
+
+    void finalize(Actions& actions) {
+      tombstones_.apply(actions);
+    }
+
+  private:
+    // Recording removals does not change the visitor observable state
+    mutable Tombstones tombstones_{};
+};
+
+// Let's add another new operation for DecayAction only
+class Decayer : public AbstractActionVisitor,
+                public ActionVisitor<DecayAction> {
+  public:
+    void visit(const DecayAction& action) const override {
+      std::cout << "Particle(s) ";
+      for(auto p : action.particles())
+      {
+        std::cout << p << " ";
+      }
+      std::cout << "will be decayed.\n";
+    }
+};
+
+template<typename OPERATION>
+void do_on_all_actions(Actions& actions)
+{
+  OPERATION operation{};
+  for (const auto& action : actions)
+  {
+    action->accept( operation );
+  }
+  if constexpr (requires { operation.finalize(actions); }) {
+    operation.finalize(actions);
+  }
+}
+
+int main() {
+  // Creating actions
+  Particles p1 = {1, 11, 111}, p2 = {42, 666, 13}, p3 = {66, 77};
+  Actions actions{};
+  actions.emplace_back(std::make_unique<ScatterAction>(std::move(p1)));
+  actions.emplace_back(std::make_unique<FluidizationAction>(std::move(p2)));
+  actions.emplace_back(std::make_unique<DecayAction>(std::move(p3)));
+
+  // Performing actions
+  std::cout << "PERFORM:\n";
+  do_on_all_actions<Performer>(actions);
+  std::cout << "REMOVAL:\n";
+  do_on_all_actions<Remover>(actions);
+  std::cout << "DECAY:\n";
+  do_on_all_actions<Decayer>(actions);
+
+  std::cout << "PARTICLES LEFT:\n";
+  for (const auto& action : actions)
+  {
+    for (auto p : action->particles())
+    {
+      std::cout << p << " ";
+    }
+    std::cout << "\n";
+  }
+}
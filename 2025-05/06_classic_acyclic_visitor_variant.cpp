@@ -13,7 +13,9 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string_view>
+#include <variant>
 #include <vector>
 
 // Taken from https://stackoverflow.com/a/56766138/14967071
@@ -50,7 +52,7 @@ class ScatterAction {
     ScatterAction(Particles p) : particles_{std::move(p)} {}
 
     // External read-access to particles
-    const Particles& particles() const { return particles_; }
+    std::span<const int> particles() const { return particles_; }
 
   private:
     Particles particles_;
@@ -61,7 +63,7 @@ class FluidizationAction {
     FluidizationAction(Particles p) : particles_{std::move(p)} {}
 
     // External read-access to particles
-    const Particles& particles() const { return particles_; }
+    std::span<const int> particles() const { return particles_; }
 
   private:
     Particles particles_;
@@ -72,7 +74,7 @@ class DecayAction {
     DecayAction(Particles p) : particles_{std::move(p)} {}
 
     // External read-access to particles
-    const Particles& particles() const { return particles_; }
+    std::span<const int> particles() const { return particles_; }
 
   private:
     Particles particles_;
@@ -104,7 +106,6 @@ class Remover {
       if(auto particles = action.particles(); particles.size() > 0)
       {
         std::cout << "Particle " << particles[0] << " will be removed.\n";
-        particles.erase(particles.begin());
       }
     }
     template<typename T>
@@ -129,12 +130,16 @@ class Decayer {
     }
 };
 
-template<typename OPERATION>
+// Several operations can be fused into a single pass over the actions: each
+// action is loaded and dispatched once and all operations are applied in order
+template<typename... OPERATIONS>
 void do_on_all_actions(const Actions& actions)
 {
   for (auto& action : actions)
   {
-    std::visit( OPERATION{}, action );
+    std::visit( [](const auto& concrete_action) {
+                  ( OPERATIONS{}(concrete_action), ... );
+                }, action );
   }
 }
 
@@ -153,4 +158,6 @@ int main() {
   do_on_all_actions<Remover>(actions);
   std::cout << "DECAY:\n";
   do_on_all_actions<Decayer>(actions);
+  std::cout << "ALL IN ONE PASS:\n";
+  do_on_all_actions<Performer, Remover, Decayer>(actions);
 }
@@ -0,0 +1,464 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/*
+ * Same actions as in 06_classic_acyclic_visitor_variant_replay.cpp, logged in
+ * a compressed format instead of fixed-size records.
+ *
+ *  1) Each record is
+ *      ↳ one tag byte: action type (2 bits), event (1 bit) and number of
+ *        particles (5 bits, the value 31 means that a varint follows);
+ *      ↳ the time, as difference of its bit pattern from the previous time,
+ *        which is zero for equal times and small for close ones (lossless
+ *        for any double, but it takes up to 9 bytes for distant times);
+ *      ↳ the particle ids, each as difference from the previous id, the first
+ *        one from the first id of the previous record.
+ *  2) Differences are zig-zag encoded and stored as varints
+ *      ↳ zig-zag maps small negative and positive numbers to small unsigned
+ *        ones (0, -1, 1, -2, ... → 0, 1, 2, 3, ...);
+ *      ↳ a varint stores 7 bits per byte, the high bit telling whether more
+ *        bytes follow, so numbers below 128 take a single byte.
+ *  3) Records are grouped in blocks
+ *      ↳ a block starts with a header (magic, payload size, number of
+ *        records) and all differences restart at each block;
+ *      ↳ each block can then be decoded on its own, or skipped unread;
+ *      ↳ a block payload is at most 64 MiB, so that a corrupt header cannot
+ *        make the decoder allocate arbitrary amounts of memory.
+ *  4) Streaming
+ *      ↳ ActionLogEncoder writes to any std::ostream, block by block, call
+ *        flush() at the end to be told about write errors (the destructor
+ *        flushes, too, but it cannot report them);
+ *      ↳ ActionLogDecoder reads from any std::istream, record by record,
+ *        reusing the same Particles storage for all records.
+ */
+
+class ScatterAction;
+class FluidizationAction;
+class DecayAction;
+using Particles = std::vector<int>;
+using Action = std::variant<ScatterAction,FluidizationAction,DecayAction>;
+using Actions = std::vector<Action>;
+
+class ScatterAction {
+  public:
+    ScatterAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+class FluidizationAction {
+  public:
+    FluidizationAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+class DecayAction {
+  public:
+    DecayAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+//=========================== COMPRESSED FORMAT ===============================
+
+enum class ActionEvent : std::uint8_t { created = 0, performed = 1 };
+
+static_assert(std::variant_size_v<Action> <= 4,
+              "The tag byte has room for 4 action types only");
+
+struct BlockHeader {
+    std::uint32_t magic;
+    std::uint32_t payload_size;
+    std::uint32_t number_of_records;
+    std::uint32_t version;
+};
+
+inline constexpr std::uint32_t block_magic = 0x4B4C4241;  // "ABLK"
+inline constexpr std::uint32_t block_version = 1;
+inline constexpr std::size_t max_payload_size = std::size_t{1} << 26;
+inline constexpr unsigned count_bits = 5;
+inline constexpr unsigned count_escape = (1u << count_bits) - 1;
+
+constexpr std::uint64_t zigzag_encode(std::int64_t value) {
+  return (static_cast<std::uint64_t>(value) << 1) ^
+         static_cast<std::uint64_t>(value >> 63);
+}
+
+constexpr std::int64_t zigzag_decode(std::uint64_t value) {
+  return static_cast<std::int64_t>(value >> 1) ^
+         -static_cast<std::int64_t>(value & 1);
+}
+
+inline void put_varint(std::vector<std::byte>& out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<std::byte>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<std::byte>(value));
+}
+
+inline std::uint64_t get_varint(std::span<const std::byte> in, std::size_t& position) {
+  std::uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (position == in.size()) {
+      throw std::runtime_error{"Truncated varint in action log"};
+    }
+    const auto byte = static_cast<std::uint64_t>(in[position++]);
+    value |= (byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw std::runtime_error{"Malformed varint in action log"};
+}
+
+// What the decoder hands out, the particles are reused from record to record
+struct DecodedRecord {
+    double time = 0.0;
+    std::uint8_t type = 0;
+    ActionEvent event = ActionEvent::created;
+    Particles particles{};
+};
+
+// Differences restart from this state at the beginning of each block
+struct DeltaState {
+    std::uint64_t time_bits = 0;
+    std::int64_t first_id = 0;
+};
+
+class ActionLogEncoder {
+  public:
+    explicit ActionLogEncoder(std::ostream& out, std::size_t block_size = 1 << 16)
+        : out_{out}, block_size_{block_size} {
+      payload_.reserve(block_size_ + 64);
+    }
+    // Rule of 5: the encoder refers to a stream and cannot be copied or moved
+    ActionLogEncoder(const ActionLogEncoder &) = delete;
+    ActionLogEncoder& operator=(const ActionLogEncoder &) = delete;
+    ActionLogEncoder(ActionLogEncoder &&) = delete;
+    ActionLogEncoder& operator=(ActionLogEncoder &&) = delete;
+    ~ActionLogEncoder() {
+      try {
+        flush();
+      } catch (const std::runtime_error&) {
+        // Nothing sensible to do here, errors are reported by flush()
+      }
+    }
+
+    void encode(double time, const Action& action, ActionEvent event) {
+      std::visit([&](const auto& concrete_action) {
+                   encode(time, static_cast<std::uint8_t>(action.index()), event,
+                          concrete_action.particles());
+                 }, action);
+    }
+
+    void encode(double time, std::uint8_t type, ActionEvent event,
+                std::span<const int> particles) {
+      // Both are packed in the tag byte, other bits would be overwritten
+      if (type >= std::variant_size_v<Action>) {
+        throw std::invalid_argument{"Unknown action type " + std::to_string(type)};
+      }
+      if (event != ActionEvent::created && event != ActionEvent::performed) {
+        throw std::invalid_argument{"Unknown action event"};
+      }
+      const auto count = particles.size();
+      const auto packed_count = count < count_escape ? count : count_escape;
+      payload_.push_back(static_cast<std::byte>(
+          type | static_cast<unsigned>(event) << 2 | packed_count << 3));
+      if (packed_count == count_escape) {
+        put_varint(payload_, count);
+      }
+      const auto time_bits = std::bit_cast<std::uint64_t>(time);
+      put_varint(payload_, zigzag_encode(
+                               static_cast<std::int64_t>(time_bits - state_.time_bits)));
+      state_.time_bits = time_bits;
+      if (count > 0) {
+        std::int64_t previous = state_.first_id;
+        state_.first_id = particles[0];
+        for (const int id : particles) {
+          put_varint(payload_, zigzag_encode(id - previous));
+          previous = id;
+        }
+      }
+      ++number_of_records_;
+      if (payload_.size() >= block_size_) {
+        flush();
+      }
+    }
+
+    // Close the current block, following records start a new one
+    void flush() {
+      if (number_of_records_ == 0) {
+        return;
+      }
+      if (payload_.size() > max_payload_size) {
+        throw std::runtime_error{"Records too large for an action log block"};
+      }
+      const BlockHeader header{block_magic,
+                               static_cast<std::uint32_t>(payload_.size()),
+                               number_of_records_, block_version};
+      out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      out_.write(reinterpret_cast<const char*>(payload_.data()),
+                 static_cast<std::streamsize>(payload_.size()));
+      if (!out_) {
+        throw std::runtime_error{"ActionLogEncoder failed to write"};
+      }
+      payload_.clear();
+      number_of_records_ = 0;
+      state_ = {};
+    }
+
+  private:
+    std::ostream& out_;
+    std::size_t block_size_;
+    std::vector<std::byte> payload_{};
+    std::uint32_t number_of_records_ = 0;
+    DeltaState state_{};
+};
+
+class ActionLogDecoder {
+  public:
+    explicit ActionLogDecoder(std::istream& in) : in_{in} {}
+
+    // Read the next record, return false at the end of the stream
+    bool next(DecodedRecord& record) {
+      while (records_left_ == 0) {
+        if (!read_block()) {
+          return false;
+        }
+      }
+      if (position_ == payload_.size()) {
+        throw std::runtime_error{"Truncated block in action log"};
+      }
+      const auto tag = static_cast<unsigned>(payload_[position_++]);
+      record.type = static_cast<std::uint8_t>(tag & 0x3);
+      record.event = static_cast<ActionEvent>(tag >> 2 & 0x1);
+      std::size_t count = tag >> 3;
+      if (count == count_escape) {
+        count = get_varint(payload_, position_);
+      }
+      // Each id takes at least one byte, a larger count can only be corrupt
+      if (count > payload_.size() - position_) {
+        throw std::runtime_error{"Corrupted particle count in action log"};
+      }
+      state_.time_bits += static_cast<std::uint64_t>(
+          zigzag_decode(get_varint(payload_, position_)));
+      record.time = std::bit_cast<double>(state_.time_bits);
+      record.particles.resize(count);
+      std::int64_t previous = state_.first_id;
+      for (auto& id : record.particles) {
+        previous += zigzag_decode(get_varint(payload_, position_));
+        id = static_cast<int>(previous);
+      }
+      if (count > 0) {
+        state_.first_id = record.particles[0];
+      }
+      --records_left_;
+      return true;
+    }
+
+    // Skip the rest of the current block, or the next one if none is open,
+    // without decoding it; return false at the end of the stream
+    bool skip_block() {
+      if (records_left_ > 0) {
+        records_left_ = 0;
+        return true;
+      }
+      BlockHeader header{};
+      if (!read_header(header)) {
+        return false;
+      }
+      in_.seekg(header.payload_size, std::ios::cur);
+      return static_cast<bool>(in_);
+    }
+
+  private:
+    bool read_header(BlockHeader& header) {
+      in_.read(reinterpret_cast<char*>(&header), sizeof(header));
+      if (in_.gcount() == 0 && in_.eof()) {
+        return false;
+      }
+      if (in_.gcount() != sizeof(header) || header.magic != block_magic) {
+        throw std::runtime_error{"Corrupted block header in action log"};
+      }
+      if (header.version != block_version) {
+        throw std::runtime_error{"Unsupported action log version"};
+      }
+      return true;
+    }
+
+    bool read_block() {
+      BlockHeader header{};
+      if (!read_header(header)) {
+        return false;
+      }
+      if (header.payload_size > max_payload_size ||
+          header.payload_size > remaining_size()) {
+        throw std::runtime_error{"Corrupted block size in action log"};
+      }
+      payload_.resize(header.payload_size);
+      in_.read(reinterpret_cast<char*>(payload_.data()), header.payload_size);
+      if (in_.gcount() != static_cast<std::streamsize>(header.payload_size)) {
+        throw std::runtime_error{"Truncated block in action log"};
+      }
+      position_ = 0;
+      records_left_ = header.number_of_records;
+      state_ = {};
+      return true;
+    }
+
+    // Bytes left in the stream, as many as possible if it cannot seek
+    std::uint64_t remaining_size() {
+      const auto here = in_.tellg();
+      if (here < 0) {
+        in_.clear();
+        return std::numeric_limits<std::uint64_t>::max();
+      }
+      in_.seekg(0, std::ios::end);
+      const auto end = in_.tellg();
+      in_.seekg(here);
+      return static_cast<std::uint64_t>(end - here);
+    }
+
+    std::istream& in_;
+    std::vector<std::byte> payload_{};
+    std::size_t position_ = 0;
+    std::uint32_t records_left_ = 0;
+    DeltaState state_{};
+};
+
+template<std::size_t I>
+Action make_action(std::span<const int> particles)
+{
+  return Action{std::in_place_index<I>, Particles(particles.begin(), particles.end())};
+}
+
+template<std::size_t... Is>
+constexpr auto make_action_table(std::index_sequence<Is...>)
+{
+  return std::array<Action (*)(std::span<const int>), sizeof...(Is)>{&make_action<Is>...};
+}
+
+// Rebuild the action, the record type is its index in the Action variant
+Action to_action(const DecodedRecord& record)
+{
+  static constexpr auto table =
+      make_action_table(std::make_index_sequence<std::variant_size_v<Action>>{});
+  if (record.type >= table.size()) {
+    throw std::runtime_error{"Unknown action type " + std::to_string(record.type)};
+  }
+  return table[record.type](record.particles);
+}
+
+// Size of the same records in the fixed-size format of the replay example
+std::size_t fixed_size_of(std::span<const int> particles)
+{
+  return (16 + 4 * particles.size() + 7) / 8 * 8;
+}
+
+int main() {
+  // Creating many actions on nearby particles, as a simulation would
+  std::mt19937 generator{42};
+  std::uniform_int_distribution<int> type{0, 2}, step{-50, 50}, neighbour{1, 20};
+  Actions actions{};
+  int particle = 100000;
+  for (int i = 0; i < 100000; ++i) {
+    particle += step(generator);
+    const Particles p = {particle, particle + neighbour(generator),
+                         particle + neighbour(generator)};
+    switch (type(generator)) {
+      case 0: actions.emplace_back(ScatterAction{{p[0], p[1]}}); break;
+      case 1: actions.emplace_back(FluidizationAction{p}); break;
+      default: actions.emplace_back(DecayAction{{p[0]}}); break;
+    }
+  }
+
+  // Encoding
+  std::stringstream stream{};
+  std::size_t fixed_size = 0;
+  {
+    ActionLogEncoder encoder{stream};
+    // Actions of the same time step share the same time
+    for (std::size_t i = 0; i < actions.size(); ++i) {
+      const auto& action = actions[i];
+      const double time = 0.1 * static_cast<double>(i / 100);
+      encoder.encode(time, action, ActionEvent::performed);
+      fixed_size += std::visit([](const auto& a) { return fixed_size_of(a.particles()); },
+                               action);
+    }
+    encoder.flush();
+  }
+  const auto compressed_size = stream.str().size();
+  std::cout << actions.size() << " actions: " << fixed_size << " bytes fixed-size, "
+            << compressed_size << " bytes compressed ("
+            << static_cast<double>(fixed_size) / compressed_size << "x smaller).\n";
+
+  // Decoding and checking
+  ActionLogDecoder decoder{stream};
+  DecodedRecord record{};
+  std::size_t decoded = 0;
+  bool same = true;
+  while (decoder.next(record)) {
+    const Action action = to_action(record);
+    same = same && decoded < actions.size() &&
+           action.index() == actions[decoded].index() &&
+           std::visit([&](const auto& a) {
+                        const auto p = a.particles();
+                        return std::equal(p.begin(), p.end(), record.particles.begin(),
+                                          record.particles.end());
+                      }, actions[decoded]);
+    ++decoded;
+  }
+  std::cout << decoded << " actions decoded, "
+            << (same ? "identical to" : "DIFFERENT FROM") << " the original ones.\n";
+
+  // Blocks are independent, the first one can be skipped unread
+  stream.clear();
+  stream.seekg(0);
+  ActionLogDecoder partial{stream};
+  partial.skip_block();
+  std::size_t rest = 0;
+  while (partial.next(record)) {
+    ++rest;
+  }
+  std::cout << rest << " actions decoded after skipping the first block.\n";
+}
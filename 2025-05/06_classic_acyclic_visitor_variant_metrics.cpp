@@ -0,0 +1,371 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/*
+ * Same acyclic visitor as in 06_classic_acyclic_visitor_variant.cpp, with
+ * metrics collected per action type in do_on_all_actions.
+ *
+ *  1) Operations return what they did with an action (Outcome)
+ *      ↳ performed, skipped (the operation cannot visit that type) or
+ *        rejected (the action did not pass a guard, e.g. too few particles).
+ *  2) Each thread counts into its own shard
+ *      ↳ a shard is aligned to a cache line, hence no false sharing;
+ *      ↳ counters are atomics written only by their own thread, with
+ *        relaxed load and store (no read-modify-write, no lock);
+ *      ↳ shards are merged only when a snapshot is taken, also while other
+ *        threads keep counting.
+ *  3) The latency of each action is put in a histogram with log2 buckets
+ *      ↳ bucket k counts latencies in [2^(k-1), 2^k) nanoseconds.
+ *  4) Compiling with -DACTION_METRICS=0 removes all of it
+ *      ↳ no clock reading, no counter, the dispatch is the plain one.
+ */
+
+#ifndef ACTION_METRICS
+#define ACTION_METRICS 1
+#endif
+
+// Taken from https://stackoverflow.com/a/56766138/14967071
+template <typename T>
+constexpr auto type_name() {
+  std::string_view name, prefix, suffix;
+#ifdef __clang__
+  name = __PRETTY_FUNCTION__;
+  prefix = "auto type_name() [T = ";
+  suffix = "]";
+#elif defined(__GNUC__)
+  name = __PRETTY_FUNCTION__;
+  prefix = "constexpr auto type_name() [with T = ";
+  suffix = "]";
+#elif defined(_MSC_VER)
+  name = __FUNCSIG__;
+  prefix = "auto __cdecl type_name<";
+  suffix = ">(void)";
+#endif
+  name.remove_prefix(prefix.size());
+  name.remove_suffix(suffix.size());
+  return name;
+}
+
+class ScatterAction;
+class FluidizationAction;
+class DecayAction;
+using Particles = std::vector<int>;
+using Action = std::variant<ScatterAction,FluidizationAction,DecayAction>;
+using Actions = std::vector<Action>;
+
+class ScatterAction {
+  public:
+    ScatterAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+class FluidizationAction {
+  public:
+    FluidizationAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+class DecayAction {
+  public:
+    DecayAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+//=============================== METRICS =====================================
+
+enum class Outcome : std::size_t { performed = 0, skipped = 1, rejected = 2 };
+
+inline constexpr std::size_t number_of_action_types =
+    std::variant_size_v<Action>;
+inline constexpr std::size_t number_of_outcomes = 3;
+inline constexpr std::size_t number_of_latency_buckets = 32;
+
+struct ActionTypeMetrics {
+    std::array<std::uint64_t, number_of_outcomes> counts{};
+    std::array<std::uint64_t, number_of_latency_buckets> latency{};
+
+    std::uint64_t count(Outcome outcome) const {
+      return counts[static_cast<std::size_t>(outcome)];
+    }
+};
+
+using MetricsSnapshot = std::array<ActionTypeMetrics, number_of_action_types>;
+
+class ActionMetrics {
+  public:
+    static ActionMetrics& instance() {
+      static ActionMetrics metrics{};
+      return metrics;
+    }
+
+    // Called by the dispatching thread only, on its own shard
+    void record(std::size_t type, Outcome outcome,
+                std::chrono::nanoseconds latency) {
+      auto& shard = thread_shard().types[type];
+      increment(shard.counts[static_cast<std::size_t>(outcome)]);
+      const auto ns = static_cast<std::uint64_t>(latency.count());
+      const auto bucket = std::min<std::size_t>(std::bit_width(ns),
+                                                number_of_latency_buckets - 1);
+      increment(shard.latency[bucket]);
+    }
+
+    // Sum of all shards, the result is consistent per counter only
+    MetricsSnapshot snapshot() const {
+      MetricsSnapshot result{};
+      std::lock_guard lock{mutex_};
+      for (const auto& shard : shards_) {
+        for (std::size_t t = 0; t < number_of_action_types; ++t) {
+          for (std::size_t o = 0; o < number_of_outcomes; ++o) {
+            result[t].counts[o] +=
+                shard->types[t].counts[o].load(std::memory_order_relaxed);
+          }
+          for (std::size_t b = 0; b < number_of_latency_buckets; ++b) {
+            result[t].latency[b] +=
+                shard->types[t].latency[b].load(std::memory_order_relaxed);
+          }
+        }
+      }
+      return result;
+    }
+
+  private:
+    using Counter = std::atomic<std::uint64_t>;
+
+    struct TypeCounters {
+        std::array<Counter, number_of_outcomes> counts{};
+        std::array<Counter, number_of_latency_buckets> latency{};
+    };
+
+    struct alignas(64) Shard {
+        std::array<TypeCounters, number_of_action_types> types{};
+    };
+
+    // Only the owning thread writes, hence a relaxed load and store suffice
+    static void increment(Counter& counter) {
+      counter.store(counter.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    }
+
+    // Shards outlive their threads, so that no count is lost
+    Shard& thread_shard() {
+      thread_local Shard* shard = nullptr;
+      if (shard == nullptr) {
+        std::lock_guard lock{mutex_};
+        shards_.push_back(std::make_unique<Shard>());
+        shard = shards_.back().get();
+      }
+      return *shard;
+    }
+
+    mutable std::mutex mutex_{};
+    std::vector<std::unique_ptr<Shard>> shards_{};
+};
+
+// Run the dispatch and, if enabled, record its outcome and latency
+template<typename DISPATCH>
+void measured(std::size_t type, DISPATCH&& dispatch)
+{
+#if ACTION_METRICS
+  const auto start = std::chrono::steady_clock::now();
+  const Outcome outcome = dispatch();
+  ActionMetrics::instance().record(type, outcome,
+                                   std::chrono::steady_clock::now() - start);
+#else
+  static_cast<void>(type);
+  dispatch();
+#endif
+}
+
+template<std::size_t... Is>
+void print_metrics(const MetricsSnapshot& snapshot, std::index_sequence<Is...>)
+{
+  constexpr std::array<std::string_view, sizeof...(Is)> names{
+      type_name<std::variant_alternative_t<Is, Action>>()...};
+  std::cout << std::setw(20) << "type" << std::setw(11) << "performed"
+            << std::setw(9) << "skipped" << std::setw(10) << "rejected"
+            << "   latency histogram [<ns]: count\n";
+  for (std::size_t t = 0; t < snapshot.size(); ++t) {
+    const auto& metrics = snapshot[t];
+    std::cout << std::setw(20) << names[t] << std::setw(11)
+              << metrics.count(Outcome::performed) << std::setw(9)
+              << metrics.count(Outcome::skipped) << std::setw(10)
+              << metrics.count(Outcome::rejected) << "  ";
+    for (std::size_t b = 0; b < metrics.latency.size(); ++b) {
+      if (metrics.latency[b] > 0) {
+        std::cout << " [<" << (std::uint64_t{1} << b)
+                  << "]: " << metrics.latency[b];
+      }
+    }
+    std::cout << "\n";
+  }
+}
+
+void print_metrics(const MetricsSnapshot& snapshot)
+{
+  print_metrics(snapshot, std::make_index_sequence<number_of_action_types>{});
+}
+
+//============================== OPERATIONS ===================================
+
+class Performer {
+  public:
+    Outcome operator()(const ScatterAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 1){
+        std::cout << "Scattering between " << particles[0] << " and " << particles[1] << ".\n";
+        return Outcome::performed;
+      }
+      return Outcome::rejected;
+    }
+    Outcome operator()(const FluidizationAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles.back() << " will be melt.\n";
+        return Outcome::performed;
+      }
+      return Outcome::rejected;
+    }
+    template<typename T>
+    Outcome operator()(const T&) const {
+        std::cout << "Performer not possible for " << type_name<T>() << " type.\n";
+        return Outcome::skipped;
+    }
+};
+
+// Let's add a new operation for FluidizationAction only
+class Remover {
+  public:
+    Outcome operator()(const FluidizationAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles[0] << " will be removed.\n";
+        return Outcome::performed;
+      }
+      return Outcome::rejected;
+    }
+    template<typename T>
+    Outcome operator()(const T&) const {
+        std::cout << "Remover not possible for " << type_name<T>() << " type.\n";
+        return Outcome::skipped;
+    }
+};
+
+class Decayer {
+  public:
+    Outcome operator()(const DecayAction& action) const {
+      std::cout << "Particle(s) ";
+      for(auto p : action.particles())
+      {
+        std::cout << p << " ";
+      }
+      std::cout << "will be decayed.\n";
+      return Outcome::performed;
+    }
+    template<typename T>
+    Outcome operator()(const T&) const {
+        std::cout << "Decayer not possible for " << type_name<T>() << " type.\n";
+        return Outcome::skipped;
+    }
+};
+
+// A silent operation, to be run on many threads
+class Validator {
+  public:
+    Outcome operator()(const ScatterAction& action) const {
+      return action.particles().size() > 1 ? Outcome::performed
+                                           : Outcome::rejected;
+    }
+    template<typename T>
+    Outcome operator()(const T&) const {
+        return Outcome::skipped;
+    }
+};
+
+// Several operations can be fused into a single pass over the actions: each
+// action is loaded and dispatched once and all operations are applied in order
+template<typename... OPERATIONS>
+void do_on_all_actions(const Actions& actions)
+{
+  for (auto& action : actions)
+  {
+    std::visit( [index = action.index()](const auto& concrete_action) {
+                  ( measured(index,
+                             [&] { return OPERATIONS{}(concrete_action); }), ... );
+                }, action );
+  }
+}
+
+int main() {
+  // Creating actions, the last one has too few particles to scatter
+  Particles p1 = {1, 11, 111}, p2 = {42, 666, 13}, p3 = {66, 77}, p4 = {5};
+  Actions actions{};
+  actions.emplace_back(ScatterAction{std::move(p1)});
+  actions.emplace_back(FluidizationAction{std::move(p2)});
+  actions.emplace_back(DecayAction{std::move(p3)});
+  actions.emplace_back(ScatterAction{std::move(p4)});
+
+  // Performing actions
+  std::cout << "PERFORM:\n";
+  do_on_all_actions<Performer>(actions);
+  std::cout << "REMOVAL:\n";
+  do_on_all_actions<Remover>(actions);
+  std::cout << "DECAY:\n";
+  do_on_all_actions<Decayer>(actions);
+
+  // Validating on several threads, each counting into its own shard
+  {
+    std::vector<std::jthread> threads{};
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&actions] {
+        for (int pass = 0; pass < 1000; ++pass) {
+          do_on_all_actions<Validator>(actions);
+        }
+      });
+    }
+  }
+
+#if ACTION_METRICS
+  std::cout << "METRICS:\n";
+  print_metrics(ActionMetrics::instance().snapshot());
+#endif
+}
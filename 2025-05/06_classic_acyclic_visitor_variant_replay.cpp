@@ -0,0 +1,532 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/*
+ * Same acyclic visitor as in 06_classic_acyclic_visitor_variant.cpp, with
+ * actions recorded to a binary log and replayed from it.
+ *
+ *  1) BinaryActionLogWriter appends one record per action
+ *      ↳ a 16-byte header (time, type, event, number of particles) followed
+ *        by the particle ids, padded to a multiple of 8 bytes;
+ *      ↳ the type is the index of the action in the Action variant, hence
+ *        the order of the alternatives must not be changed;
+ *      ↳ records are collected in a buffer and written in large chunks;
+ *      ↳ call flush() before destroying the writer to be told about write
+ *        errors, the destructor cannot report them.
+ *  2) MappedActionLog memory-maps a log file for reading
+ *      ↳ iterating gives a RecordView per record, whose particles are a span
+ *        pointing directly into the mapping, nothing is parsed nor copied;
+ *      ↳ the kernel reads the file in on demand, also for multi-GB files.
+ *  3) From records back to actions
+ *      ↳ to_action(record) rebuilds the Action (copying the ids);
+ *      ↳ replay<OPERATIONS...>(log) feeds all operations in one pass, it
+ *        reuses one action per type, whose particles are overwritten record
+ *        after record, hence it does not allocate once they are big enough.
+ *  4) The format is not portable: it uses the byte order of the machine
+ *      ↳ a marker in the file header detects a mismatch when reading.
+ */
+
+// Taken from https://stackoverflow.com/a/56766138/14967071
+template <typename T>
+constexpr auto type_name() {
+  std::string_view name, prefix, suffix;
+#ifdef __clang__
+  name = __PRETTY_FUNCTION__;
+  prefix = "auto type_name() [T = ";
+  suffix = "]";
+#elif defined(__GNUC__)
+  name = __PRETTY_FUNCTION__;
+  prefix = "constexpr auto type_name() [with T = ";
+  suffix = "]";
+#elif defined(_MSC_VER)
+  name = __FUNCSIG__;
+  prefix = "auto __cdecl type_name<";
+  suffix = ">(void)";
+#endif
+  name.remove_prefix(prefix.size());
+  name.remove_suffix(suffix.size());
+  return name;
+}
+
+class ScatterAction;
+class FluidizationAction;
+class DecayAction;
+using Particles = std::vector<int>;
+using Action = std::variant<ScatterAction,FluidizationAction,DecayAction>;
+using Actions = std::vector<Action>;
+
+class ScatterAction {
+  public:
+    ScatterAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+    // Replace the particles, reusing the allocated memory
+    void assign(std::span<const int> ids) {
+      particles_.assign(ids.begin(), ids.end());
+    }
+
+  private:
+    Particles particles_;
+};
+
+class FluidizationAction {
+  public:
+    FluidizationAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+    // Replace the particles, reusing the allocated memory
+    void assign(std::span<const int> ids) {
+      particles_.assign(ids.begin(), ids.end());
+    }
+
+  private:
+    Particles particles_;
+};
+
+class DecayAction {
+  public:
+    DecayAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+    // Replace the particles, reusing the allocated memory
+    void assign(std::span<const int> ids) {
+      particles_.assign(ids.begin(), ids.end());
+    }
+
+  private:
+    Particles particles_;
+};
+
+//============================ BINARY FORMAT ==================================
+
+enum class ActionEvent : std::uint16_t { created = 0, performed = 1 };
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+};
+
+struct RecordHeader {
+    double time;
+    std::uint16_t type;
+    std::uint16_t event;
+    std::uint32_t number_of_particles;
+};
+
+static_assert(sizeof(FileHeader) == 16 && sizeof(RecordHeader) == 16);
+static_assert(std::is_trivially_copyable_v<RecordHeader>);
+static_assert(sizeof(int) == sizeof(std::int32_t), "Particle ids are stored as int32");
+
+inline constexpr char log_magic[8] = {'A', 'C', 'T', 'I', 'O', 'N', 'S', '\0'};
+inline constexpr std::uint32_t log_byte_order = 0x01020304;
+inline constexpr std::uint32_t log_version = 1;
+inline constexpr std::size_t record_alignment = alignof(RecordHeader);
+
+constexpr std::size_t padded_size(std::size_t number_of_particles) {
+  const auto size =
+      sizeof(RecordHeader) + number_of_particles * sizeof(std::int32_t);
+  return (size + record_alignment - 1) / record_alignment * record_alignment;
+}
+
+// A record as found in the log, the particles point into the mapped file
+struct RecordView {
+    double time;
+    std::uint16_t type;
+    ActionEvent event;
+    std::span<const int> particles;
+};
+
+class BinaryActionLogWriter {
+  public:
+    explicit BinaryActionLogWriter(const std::filesystem::path& path,
+                                   std::size_t buffer_size = 1 << 20)
+        : fd_{::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)},
+          buffer_size_{buffer_size} {
+      if (fd_ < 0) {
+        throw std::system_error{errno, std::generic_category(),
+                                "Cannot open " + path.string()};
+      }
+      buffer_.reserve(buffer_size_);
+      FileHeader header{};
+      std::memcpy(header.magic, log_magic, sizeof(log_magic));
+      header.byte_order = log_byte_order;
+      header.version = log_version;
+      append(&header, sizeof(header));
+    }
+    // Rule of 5: the writer owns a file descriptor, no copy and no move
+    BinaryActionLogWriter(const BinaryActionLogWriter &) = delete;
+    BinaryActionLogWriter& operator=(const BinaryActionLogWriter &) = delete;
+    BinaryActionLogWriter(BinaryActionLogWriter &&) = delete;
+    BinaryActionLogWriter& operator=(BinaryActionLogWriter &&) = delete;
+    ~BinaryActionLogWriter() {
+      try {
+        flush();
+      } catch (const std::system_error&) {
+        // Nothing sensible to do here, errors are reported by flush()
+      }
+      ::close(fd_);
+    }
+
+    void record(double time, const Action& action, ActionEvent event) {
+      std::visit([&](const auto& concrete_action) {
+                   const auto particles = concrete_action.particles();
+                   const RecordHeader header{
+                       time, static_cast<std::uint16_t>(action.index()),
+                       static_cast<std::uint16_t>(event),
+                       static_cast<std::uint32_t>(particles.size())};
+                   const auto size = padded_size(particles.size());
+                   if (buffer_.size() + size > buffer_size_) {
+                     flush();
+                   }
+                   append(&header, sizeof(header));
+                   append(particles.data(), particles.size_bytes());
+                   buffer_.resize(buffer_.size() + size - sizeof(header) -
+                                  particles.size_bytes());
+                 }, action);
+    }
+
+    void flush() {
+      const std::byte* data = buffer_.data();
+      std::size_t remaining = buffer_.size();
+      while (remaining > 0) {
+        const auto written = ::write(fd_, data, remaining);
+        if (written < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throw std::system_error{errno, std::generic_category(),
+                                  "BinaryActionLogWriter failed to write"};
+        }
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+      }
+      buffer_.clear();
+    }
+
+  private:
+    void append(const void* data, std::size_t size) {
+      const auto* bytes = static_cast<const std::byte*>(data);
+      buffer_.insert(buffer_.end(), bytes, bytes + size);
+    }
+
+    int fd_;
+    std::size_t buffer_size_;
+    std::vector<std::byte> buffer_{};
+};
+
+class MappedActionLog {
+  public:
+    class iterator {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = RecordView;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const std::byte* position, const std::byte* end)
+            : position_{position}, end_{end} { read(); }
+
+        const RecordView& operator*() const { return current_; }
+        const RecordView* operator->() const { return &current_; }
+        iterator& operator++() {
+          position_ += padded_size(current_.particles.size());
+          read();
+          return *this;
+        }
+        iterator operator++(int) {
+          auto old = *this;
+          ++*this;
+          return old;
+        }
+        bool operator==(const iterator& other) const {
+          return position_ == other.position_;
+        }
+
+      private:
+        void read() {
+          if (position_ == end_) {
+            return;
+          }
+          RecordHeader header;
+          if (static_cast<std::size_t>(end_ - position_) < sizeof(header)) {
+            throw std::runtime_error{"Truncated record in action log"};
+          }
+          std::memcpy(&header, position_, sizeof(header));
+          if (static_cast<std::size_t>(end_ - position_) <
+              padded_size(header.number_of_particles)) {
+            throw std::runtime_error{"Truncated record in action log"};
+          }
+          // The mapping is page aligned and records are 8-byte aligned
+          const auto* ids =
+              reinterpret_cast<const int*>(position_ + sizeof(header));
+          current_ = {header.time, header.type,
+                      static_cast<ActionEvent>(header.event),
+                      {ids, header.number_of_particles}};
+        }
+
+        const std::byte* position_ = nullptr;
+        const std::byte* end_ = nullptr;
+        RecordView current_{};
+    };
+
+    explicit MappedActionLog(const std::filesystem::path& path) {
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(),
+                                "Cannot open " + path.string()};
+      }
+      struct stat status{};
+      if (::fstat(fd, &status) != 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error{error, std::generic_category(),
+                                "Cannot stat " + path.string()};
+      }
+      size_ = static_cast<std::size_t>(status.st_size);
+      if (size_ > 0) {
+        void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+          const int error = errno;
+          ::close(fd);
+          throw std::system_error{error, std::generic_category(),
+                                  "Cannot map " + path.string()};
+        }
+        data_ = static_cast<const std::byte*>(data);
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+      }
+      ::close(fd);  // the mapping stays valid
+      try {
+        check_header();
+      } catch (...) {
+        // The destructor does not run if the constructor throws
+        if (data_) {
+          ::munmap(const_cast<std::byte*>(data_), size_);
+        }
+        throw;
+      }
+    }
+    // Rule of 5: the log owns a mapping and cannot be copied or moved
+    MappedActionLog(const MappedActionLog &) = delete;
+    MappedActionLog& operator=(const MappedActionLog &) = delete;
+    MappedActionLog(MappedActionLog &&) = delete;
+    MappedActionLog& operator=(MappedActionLog &&) = delete;
+    ~MappedActionLog() {
+      if (data_) {
+        ::munmap(const_cast<std::byte*>(data_), size_);
+      }
+    }
+
+    iterator begin() const {
+      return {data_ + sizeof(FileHeader), data_ + size_};
+    }
+    iterator end() const { return {data_ + size_, data_ + size_}; }
+
+  private:
+    void check_header() {
+      FileHeader header{};
+      if (size_ < sizeof(header)) {
+        throw std::runtime_error{"Not an action log (file too short)"};
+      }
+      std::memcpy(&header, data_, sizeof(header));
+      if (std::memcmp(header.magic, log_magic, sizeof(log_magic)) != 0) {
+        throw std::runtime_error{"Not an action log (wrong magic)"};
+      }
+      if (header.byte_order != log_byte_order) {
+        throw std::runtime_error{"Action log written with another byte order"};
+      }
+      if (header.version != log_version) {
+        throw std::runtime_error{"Unsupported action log version"};
+      }
+    }
+
+    const std::byte* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+template<std::size_t I>
+Action make_action(std::span<const int> particles)
+{
+  return Action{std::in_place_index<I>, Particles(particles.begin(), particles.end())};
+}
+
+template<std::size_t... Is>
+constexpr auto make_action_table(std::index_sequence<Is...>)
+{
+  return std::array<Action (*)(std::span<const int>), sizeof...(Is)>{&make_action<Is>...};
+}
+
+void check_action_type(const RecordView& record)
+{
+  if (record.type >= std::variant_size_v<Action>) {
+    throw std::runtime_error{"Unknown action type " + std::to_string(record.type)};
+  }
+}
+
+// Rebuild the action, the record type is its index in the Action variant
+Action to_action(const RecordView& record)
+{
+  static constexpr auto table =
+      make_action_table(std::make_index_sequence<std::variant_size_v<Action>>{});
+  check_action_type(record);
+  return table[record.type](record.particles);
+}
+
+// One action per type, with no particles, at the index of its type
+template<std::size_t... Is>
+auto make_reusable_actions(std::index_sequence<Is...>)
+{
+  return std::array<Action, sizeof...(Is)>{make_action<Is>({})...};
+}
+
+//============================== OPERATIONS ===================================
+
+class Performer {
+  public:
+    void operator()(const ScatterAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 1){
+        std::cout << "Scattering between " << particles[0] << " and " << particles[1] << ".\n";
+      }
+    }
+    void operator()(const FluidizationAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles.back() << " will be melt.\n";
+      }
+    }
+    template<typename T>
+    void operator()(const T&) const {
+        std::cout << "Performer not possible for " << type_name<T>() << " type.\n";
+    }
+};
+
+// Let's add a new operation for FluidizationAction only
+class Remover {
+  public:
+    void operator()(const FluidizationAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles[0] << " will be removed.\n";
+      }
+    }
+    template<typename T>
+    void operator()(const T&) const {
+        std::cout << "Remover not possible for " << type_name<T>() << " type.\n";
+    }
+};
+
+class Decayer {
+  public:
+    void operator()(const DecayAction& action) const {
+      std::cout << "Particle(s) ";
+      for(auto p : action.particles())
+      {
+        std::cout << p << " ";
+      }
+      std::cout << "will be decayed.\n";
+    }
+    template<typename T>
+    void operator()(const T&) const {
+        std::cout << "Decayer not possible for " << type_name<T>() << " type.\n";
+    }
+};
+
+// Feed the performed actions of the log to all operations, in one pass
+template<typename... OPERATIONS>
+void replay(const MappedActionLog& log)
+{
+  auto actions =
+      make_reusable_actions(std::make_index_sequence<std::variant_size_v<Action>>{});
+  for (const RecordView& record : log)
+  {
+    if (record.event != ActionEvent::performed) {
+      continue;
+    }
+    check_action_type(record);
+    std::cout << "[t = " << record.time << "] ";
+    std::visit( [&record](auto& concrete_action) {
+                  concrete_action.assign(record.particles);
+                  ( OPERATIONS{}(std::as_const(concrete_action)), ... );
+                }, actions[record.type] );
+  }
+}
+
+int main() {
+  // Creating actions
+  Particles p1 = {1, 11, 111}, p2 = {42, 666, 13}, p3 = {66, 77};
+  Actions actions{};
+  actions.emplace_back(ScatterAction{std::move(p1)});
+  actions.emplace_back(FluidizationAction{std::move(p2)});
+  actions.emplace_back(DecayAction{std::move(p3)});
+
+  // Recording creation and performing of all actions
+  // One file per process, so that concurrent runs do not interfere
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("actions_" + std::to_string(::getpid()) + ".bin");
+  {
+    BinaryActionLogWriter writer{path};
+    double time = 0.0;
+    for (const auto& action : actions) {
+      writer.record(time, action, ActionEvent::created);
+    }
+    for (const auto& action : actions) {
+      time += 0.5;
+      writer.record(time, action, ActionEvent::performed);
+    }
+    writer.flush();
+  }
+  std::cout << "Recorded " << 2 * actions.size() << " records in "
+            << std::filesystem::file_size(path) << " bytes.\n";
+
+  // Zero-copy inspection of the records
+  MappedActionLog log{path};
+  std::size_t created = 0, particles = 0;
+  for (const RecordView& record : log) {
+    created += record.event == ActionEvent::created;
+    particles += record.particles.size();
+  }
+  std::cout << created << " actions created, " << particles
+            << " particle ids in total.\n";
+
+  // Replaying
+  std::cout << "REPLAY (perform, remove and decay):\n";
+  replay<Performer, Remover, Decayer>(log);
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,420 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/*
+ * Same acyclic visitor as in 06_classic_acyclic_visitor_variant.cpp, with the
+ * dispatch passes traced on a timeline.
+ *
+ *  1) TRACE_SCOPE(tracer, "NAME") records when the enclosing scope begins and
+ *     how long it lasts
+ *      ↳ used for each pass in main() and for each batch of actions;
+ *      ↳ names must be string literals, only their address is stored.
+ *  2) Each thread records into its own ring buffer
+ *      ↳ no lock and no allocation while tracing, the buffer has a fixed
+ *        capacity, allocated when the thread records its first event;
+ *      ↳ when full, the oldest events are overwritten (and counted as lost),
+ *        so memory and overhead stay bounded in long runs.
+ *  3) write_json(stream) writes the Chrome trace-event format
+ *      ↳ open the file in https://ui.perfetto.dev or chrome://tracing;
+ *      ↳ it must be called when no thread is tracing anymore.
+ *  4) Compiling with -DACTION_TRACING=0 removes all scopes.
+ */
+
+#ifndef ACTION_TRACING
+#define ACTION_TRACING 1
+#endif
+
+class Tracer {
+  public:
+    explicit Tracer(std::size_t capacity_per_thread = 1 << 14)
+        : capacity_{std::max<std::size_t>(capacity_per_thread, 1)} {}
+    // Rule of 5: threads refer to the tracer, which cannot be copied or moved
+    Tracer(const Tracer &) = delete;
+    Tracer& operator=(const Tracer &) = delete;
+    Tracer(Tracer &&) = delete;
+    Tracer& operator=(Tracer &&) = delete;
+    ~Tracer() = default;
+
+    using Clock = std::chrono::steady_clock;
+
+    void record(const char* name, const char* category,
+                Clock::time_point begin, Clock::time_point end) {
+      auto& ring = thread_ring();
+      ring.events[ring.recorded % capacity_] = {name, category, begin - start_,
+                                                end - begin};
+      ++ring.recorded;
+    }
+
+    // Write all recorded events, no thread may be tracing in the meanwhile
+    void write_json(std::ostream& out) const {
+      std::lock_guard lock{mutex_};
+      const auto flags = out.flags();
+      const auto precision = out.precision();
+      out << std::fixed << std::setprecision(3);
+      out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+      bool first = true;
+      for (const auto& ring : rings_) {
+        out << (first ? "" : ",")
+            << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+            << ring->tid << ",\"args\":{\"name\":\"thread " << ring->tid
+            << "\"}}";
+        first = false;
+        const auto kept = std::min<std::uint64_t>(ring->recorded, capacity_);
+        for (auto i = ring->recorded - kept; i < ring->recorded; ++i) {
+          const auto& event = ring->events[i % capacity_];
+          out << ",\n{\"name\":\"";
+          write_escaped(out, event.name);
+          out << "\",\"cat\":\"";
+          write_escaped(out, event.category);
+          out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->tid
+              << ",\"ts\":" << microseconds(event.begin)
+              << ",\"dur\":" << microseconds(event.duration) << "}";
+        }
+      }
+      out << "\n]}\n";
+      out.flags(flags);
+      out.precision(precision);
+    }
+
+    std::uint64_t number_of_events() const { return count(false); }
+    std::uint64_t number_of_lost_events() const { return count(true); }
+
+  private:
+    struct Event {
+        const char* name;
+        const char* category;
+        Clock::duration begin;
+        Clock::duration duration;
+    };
+
+    struct Ring {
+        int tid;
+        std::vector<Event> events;
+        std::uint64_t recorded = 0;
+    };
+
+    Ring& thread_ring() {
+      // Cached per thread and per tracer, the id (not the address) identifies
+      // the tracer. A thread has one entry per tracer it ever traced into,
+      // entries of destroyed tracers are never matched again.
+      struct Entry {
+          std::uint64_t tracer_id;
+          Ring* ring;
+      };
+      thread_local std::vector<Entry> cache{};
+      for (const auto& entry : cache) {
+        if (entry.tracer_id == id_) {
+          return *entry.ring;
+        }
+      }
+      std::lock_guard lock{mutex_};
+      rings_.push_back(std::make_unique<Ring>(Ring{
+          static_cast<int>(rings_.size()), std::vector<Event>(capacity_)}));
+      cache.push_back({id_, rings_.back().get()});
+      return *cache.back().ring;
+    }
+
+    std::uint64_t count(bool lost) const {
+      std::lock_guard lock{mutex_};
+      std::uint64_t result = 0;
+      for (const auto& ring : rings_) {
+        const auto kept = std::min<std::uint64_t>(ring->recorded, capacity_);
+        result += lost ? ring->recorded - kept : kept;
+      }
+      return result;
+    }
+
+    static double microseconds(Clock::duration d) {
+      return std::chrono::duration<double, std::micro>(d).count();
+    }
+
+    static void write_escaped(std::ostream& out, std::string_view text) {
+      for (char c : text) {
+        if (c == '"' || c == '\\') {
+          out << '\\';
+        }
+        out << c;
+      }
+    }
+
+    inline static std::atomic<std::uint64_t> next_id_{1};
+
+    const std::uint64_t id_ = next_id_++;
+    const std::size_t capacity_;
+    const Clock::time_point start_ = Clock::now();
+    mutable std::mutex mutex_{};
+    std::vector<std::unique_ptr<Ring>> rings_{};
+};
+
+class TraceScope {
+  public:
+    TraceScope(Tracer& tracer, const char* name, const char* category)
+        : tracer_{tracer}, name_{name}, category_{category},
+          begin_{Tracer::Clock::now()} {}
+    // Rule of 5: a scope is bound to where it is declared
+    TraceScope(const TraceScope &) = delete;
+    TraceScope& operator=(const TraceScope &) = delete;
+    TraceScope(TraceScope &&) = delete;
+    TraceScope& operator=(TraceScope &&) = delete;
+    ~TraceScope() {
+      tracer_.record(name_, category_, begin_, Tracer::Clock::now());
+    }
+
+  private:
+    Tracer& tracer_;
+    const char* name_;
+    const char* category_;
+    Tracer::Clock::time_point begin_;
+};
+
+#define TRACE_CONCATENATE_IMPL(a, b) a##b
+#define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_IMPL(a, b)
+#if ACTION_TRACING
+#define TRACE_SCOPE(tracer, name, category) \
+  TraceScope TRACE_CONCATENATE(trace_scope_, __LINE__){tracer, name, category}
+#else
+#define TRACE_SCOPE(tracer, name, category) static_cast<void>(tracer)
+#endif
+
+// Taken from https://stackoverflow.com/a/56766138/14967071
+template <typename T>
+constexpr auto type_name() {
+  std::string_view name, prefix, suffix;
+#ifdef __clang__
+  name = __PRETTY_FUNCTION__;
+  prefix = "auto type_name() [T = ";
+  suffix = "]";
+#elif defined(__GNUC__)
+  name = __PRETTY_FUNCTION__;
+  prefix = "constexpr auto type_name() [with T = ";
+  suffix = "]";
+#elif defined(_MSC_VER)
+  name = __FUNCSIG__;
+  prefix = "auto __cdecl type_name<";
+  suffix = ">(void)";
+#endif
+  name.remove_prefix(prefix.size());
+  name.remove_suffix(suffix.size());
+  return name;
+}
+
+class ScatterAction;
+class FluidizationAction;
+class DecayAction;
+using Particles = std::vector<int>;
+using Action = std::variant<ScatterAction,FluidizationAction,DecayAction>;
+using Actions = std::vector<Action>;
+
+class ScatterAction {
+  public:
+    ScatterAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+class FluidizationAction {
+  public:
+    FluidizationAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+class DecayAction {
+  public:
+    DecayAction(Particles p) : particles_{std::move(p)} {}
+
+    // External read-access to particles
+    std::span<const int> particles() const { return particles_; }
+
+  private:
+    Particles particles_;
+};
+
+class Performer {
+  public:
+    void operator()(const ScatterAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 1){
+        std::cout << "Scattering between " << particles[0] << " and " << particles[1] << ".\n";
+      }
+    }
+    void operator()(const FluidizationAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles.back() << " will be melt.\n";
+      }
+    }
+    template<typename T>
+    void operator()(const T&) const {
+        std::cout << "Performer not possible for " << type_name<T>() << " type.\n";
+    }
+};
+
+// Let's add a new operation for FluidizationAction only
+class Remover {
+  public:
+    void operator()(const FluidizationAction& action) const {
+      if(auto particles = action.particles(); particles.size() > 0)
+      {
+        std::cout << "Particle " << particles[0] << " will be removed.\n";
+      }
+    }
+    template<typename T>
+    void operator()(const T&) const {
+        std::cout << "Remover not possible for " << type_name<T>() << " type.\n";
+    }
+};
+
+class Decayer {
+  public:
+    void operator()(const DecayAction& action) const {
+      std::cout << "Particle(s) ";
+      for(auto p : action.particles())
+      {
+        std::cout << p << " ";
+      }
+      std::cout << "will be decayed.\n";
+    }
+    template<typename T>
+    void operator()(const T&) const {
+        std::cout << "Decayer not possible for " << type_name<T>() << " type.\n";
+    }
+};
+
+// A silent operation, cheap enough to run on many actions
+class ParticleCounter {
+  public:
+    explicit ParticleCounter(std::size_t& count) : count_{count} {}
+    template<typename T>
+    void operator()(const T& action) const {
+      count_ += action.particles().size();
+    }
+
+  private:
+    std::size_t& count_;
+};
+
+template<typename... OPERATIONS>
+void do_on_all_actions(std::span<const Action> actions)
+{
+  for (auto& action : actions)
+  {
+    std::visit( [](const auto& concrete_action) {
+                  ( OPERATIONS{}(concrete_action), ... );
+                }, action );
+  }
+}
+
+// Actions are split in batches, distributed round-robin among the threads
+std::size_t count_particles_in_parallel(const Actions& actions, Tracer& tracer,
+                                        int number_of_threads,
+                                        std::size_t batch_size)
+{
+  std::vector<std::size_t> counts(number_of_threads, 0);
+  {
+    std::vector<std::jthread> threads{};
+    for (int t = 0; t < number_of_threads; ++t) {
+      threads.emplace_back([&, t] {
+        std::size_t count = 0;
+        const ParticleCounter counter{count};
+        for (std::size_t begin = t * batch_size; begin < actions.size();
+             begin += number_of_threads * batch_size) {
+          TRACE_SCOPE(tracer, "batch", "batch");
+          const auto end = std::min(begin + batch_size, actions.size());
+          for (std::size_t i = begin; i < end; ++i) {
+            std::visit(counter, actions[i]);
+          }
+        }
+        counts[t] = count;
+      });
+    }
+  }
+  std::size_t total = 0;
+  for (auto count : counts) {
+    total += count;
+  }
+  return total;
+}
+
+int main() {
+  Tracer tracer{};
+
+  // Creating actions
+  Particles p1 = {1, 11, 111}, p2 = {42, 666, 13}, p3 = {66, 77};
+  Actions actions{};
+  actions.emplace_back(ScatterAction{std::move(p1)});
+  actions.emplace_back(FluidizationAction{std::move(p2)});
+  actions.emplace_back(DecayAction{std::move(p3)});
+
+  // Performing actions, each pass is traced
+  {
+    TRACE_SCOPE(tracer, "PERFORM", "pass");
+    std::cout << "PERFORM:\n";
+    do_on_all_actions<Performer>(actions);
+  }
+  {
+    TRACE_SCOPE(tracer, "REMOVAL", "pass");
+    std::cout << "REMOVAL:\n";
+    do_on_all_actions<Remover>(actions);
+  }
+  {
+    TRACE_SCOPE(tracer, "DECAY", "pass");
+    std::cout << "DECAY:\n";
+    do_on_all_actions<Decayer>(actions);
+  }
+
+  // Many more actions, counted batch by batch on several threads
+  Actions many_actions{};
+  for (int i = 0; i < 1'000'000; ++i) {
+    many_actions.emplace_back(ScatterAction{{i, i + 1}});
+  }
+  std::size_t particles = 0;
+  {
+    TRACE_SCOPE(tracer, "COUNT", "pass");
+    particles = count_particles_in_parallel(many_actions, tracer, 4, 10'000);
+  }
+  std::cout << "COUNT: " << particles << " particles.\n";
+
+  // All threads are done, the trace can be written
+  const auto path =
+      std::filesystem::temp_directory_path() / "actions_trace.json";
+  std::ofstream file{path};
+  tracer.write_json(file);
+  std::cout << tracer.number_of_events() << " events ("
+            << tracer.number_of_lost_events() << " lost) written to " << path
+            << ", to be opened in https://ui.perfetto.dev\n";
+}
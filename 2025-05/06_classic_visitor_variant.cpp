@@ -13,6 +13,7 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string_view>
 #include <variant>
 #include <vector>
@@ -50,7 +51,7 @@ class ScatterAction {
     ScatterAction(Particles p) : particles_{std::move(p)} {}
 
     // External read-access to particles
-    const Particles& particles() const { return particles_; }
+    std::span<const int> particles() const { return particles_; }
 
   private:
     Particles particles_;
@@ -61,7 +62,7 @@ class FluidizationAction {
     FluidizationAction(Particles p) : particles_{std::move(p)} {}
 
     // External read-access to particles
-    const Particles& particles() const { return particles_; }
+    std::span<const int> particles() const { return particles_; }
 
   private:
     Particles particles_;
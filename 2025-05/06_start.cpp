@@ -13,6 +13,7 @@
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string_view>
 #include <vector>
 
@@ -55,7 +56,7 @@ class Action {
     virtual ~Action() = default;
 
     // External read-access to particles
-    const Particles& particles() const { return particles_; }
+    std::span<const int> particles() const { return particles_; }
 
     // Operations
     virtual void perform() const = 0;
@@ -0,0 +1,207 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <vector>
+
+/*
+ * Same actions as in 06_start.cpp, but the particles of all actions live in
+ * a single buffer owned by an ActionBatch, in compressed-sparse-row (CSR)
+ * style:
+ *
+ *     particle_ids_ = [ 1 11 111 | 2 22 222 | 66 77 ]
+ *     offsets_      = [ 0          3          6       8 ]
+ *
+ *  1) The particles of the i-th action are particle_ids_[offsets_[i]] up to
+ *     particle_ids_[offsets_[i+1]] (excluded).
+ *      ↳ no heap allocation and no 24-byte std::vector header per action;
+ *      ↳ a scan over all particle ids is a linear walk in memory.
+ *  2) Actions expose their particles as std::span<const int>, a non-owning
+ *     view into the batch buffer.
+ *      ↳ an action stores its batch and its index, not a pointer into the
+ *        buffer, because the buffer may reallocate while the batch grows;
+ *      ↳ hence the batch must outlive its actions and cannot be moved.
+ */
+
+class ActionBatch;
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  Action(const ActionBatch& batch, std::size_t index)
+      : batch_{&batch}, index_{index} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles (a view into the batch buffer)
+  std::span<const int> particles() const;
+
+  // Operations
+  virtual void perform() const = 0;
+
+ private:
+  const ActionBatch* batch_;
+  std::size_t index_;
+};
+
+class ScatterAction : public Action {
+ public:
+  using Action::Action;
+  void perform() const override {
+    if (auto p = particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+};
+
+class FluidizationAction : public Action {
+ public:
+  using Action::Action;
+  void perform() const override {
+    if (auto p = particles(); p.size() > 0) {
+      std::cout << "Particle " << p.back() << " will be melt.\n";
+    }
+  }
+};
+
+class DecayAction : public Action {
+ public:
+  using Action::Action;
+  void perform() const override {
+    std::cout << "Particle(s) ";
+    for (auto p : particles()) {
+      std::cout << p << " ";
+    }
+    std::cout << "will be decayed.\n";
+  }
+};
+
+class ActionBatch {
+ public:
+  using size_type = std::size_t;
+  using Actions = std::vector<std::unique_ptr<Action>>;
+
+  ActionBatch() = default;
+  // Actions refer back to their batch, which therefore must stay in place
+  ActionBatch(const ActionBatch&) = delete;
+  ActionBatch& operator=(const ActionBatch&) = delete;
+  ActionBatch(ActionBatch&&) = delete;
+  ActionBatch& operator=(ActionBatch&&) = delete;
+
+  void reserve(size_type number_of_actions, size_type number_of_particles) {
+    actions_.reserve(number_of_actions);
+    offsets_.reserve(number_of_actions + 1);
+    particle_ids_.reserve(number_of_particles);
+  }
+
+  // Everything which can throw happens before the batch is modified or while
+  // only particle_ids_ is (with strong guarantee), so that offsets_ and
+  // actions_ always agree
+  template <typename T>
+  T& emplace(std::span<const int> ids) {
+    auto action = std::make_unique<T>(*this, actions_.size());
+    T& reference = *action;
+    make_room_for_one_more(offsets_);
+    make_room_for_one_more(actions_);
+    append_particles(ids);
+    offsets_.push_back(particle_ids_.size());
+    actions_.push_back(std::move(action));
+    return reference;
+  }
+
+  template <typename T>
+  T& emplace(std::initializer_list<int> ids) {
+    return emplace<T>(std::span<const int>{ids.begin(), ids.size()});
+  }
+
+  std::span<const int> particles(size_type i) const {
+    return {particle_ids_.data() + offsets_[i], offsets_[i + 1] - offsets_[i]};
+  }
+
+  // Bulk read-access to the particles of all actions
+  std::span<const int> all_particles() const { return particle_ids_; }
+
+  size_type size() const noexcept { return actions_.size(); }
+  bool empty() const noexcept { return actions_.empty(); }
+
+  Actions::const_iterator begin() const noexcept { return actions_.begin(); }
+  Actions::const_iterator end() const noexcept { return actions_.end(); }
+
+ private:
+  template <typename V>
+  static void make_room_for_one_more(V& v) {
+    if (v.size() == v.capacity()) {
+      v.reserve(std::max<size_type>(1, 2 * v.capacity()));
+    }
+  }
+
+  // The ids may be the particles of another action of this batch, which
+  // would dangle if particle_ids_ reallocates: in that case copy by index
+  void append_particles(std::span<const int> ids) {
+    const int* begin = particle_ids_.data();
+    const int* end = begin + particle_ids_.size();
+    if (!(std::less_equal<>{}(begin, ids.data()) &&
+          std::less<>{}(ids.data(), end))) {
+      particle_ids_.insert(particle_ids_.end(), ids.begin(), ids.end());
+      return;
+    }
+    const auto first = static_cast<size_type>(ids.data() - begin);
+    const auto size = particle_ids_.size();
+    particle_ids_.resize(size + ids.size());
+    std::copy_n(particle_ids_.begin() + first, ids.size(),
+                particle_ids_.begin() + size);
+  }
+
+  std::vector<int> particle_ids_{};
+  std::vector<size_type> offsets_{0};
+  Actions actions_{};
+};
+
+std::span<const int> Action::particles() const {
+  return batch_->particles(index_);
+}
+
+void perform_all_actions(const ActionBatch& actions) {
+  for (const auto& action : actions) {
+    action->perform();
+  }
+}
+
+int main() {
+  // Creating actions
+  ActionBatch actions{};
+  actions.reserve(3, 8);
+  actions.emplace<ScatterAction>({1, 11, 111});
+  actions.emplace<FluidizationAction>({2, 22, 222});
+  actions.emplace<DecayAction>({66, 77});
+  // Particles of an action of the same batch can be reused
+  actions.emplace<DecayAction>(actions.begin()[0]->particles());
+
+  // Performing actions
+  std::cout << "PERFORM:\n";
+  perform_all_actions(actions);
+
+  // Bulk scan over all particle ids, without visiting the actions
+  const auto ids = actions.all_particles();
+  std::cout << "Largest particle id among " << ids.size()
+            << " particles: " << *std::max_element(ids.begin(), ids.end())
+            << "\n";
+}
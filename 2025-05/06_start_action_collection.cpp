@@ -0,0 +1,216 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Same actions as in 06_start.cpp, but stored in a poly-collection-like
+ * container instead of a std::vector<std::unique_ptr<Action>>.
+ *
+ *  1) One contiguous segment (a std::vector) per concrete action type
+ *      ↳ no heap allocation per action, only one per segment growth;
+ *      ↳ actions of the same type are adjacent in memory (prefetch-friendly).
+ *  2) Iteration walks segment by segment
+ *      ↳ inside a segment the static type is known, hence calls on the
+ *        (final) concrete classes are resolved at compile time;
+ *      ↳ no branch misprediction on the virtual call target.
+ *  3) The price to pay
+ *      ↳ the relative order of actions of different types is lost;
+ *      ↳ the set of concrete types must be known where the collection is
+ *        declared;
+ *      ↳ actions must be movable, since segments may reallocate.
+ *  4) Actions are built in place, in their segment
+ *      ↳ emplace<T>(args...) perfectly forwards its arguments to the
+ *        constructor of T (see print_uref_type in 2025-01/03.cpp);
+ *      ↳ particles can be given as initializer list, iterator range or span
+ *        of ids, so that no intermediate Particles has to be built and moved.
+ *
+ * WANNA DIG MORE?
+ *  -> Boost.PolyCollection by Joaquín M López Muñoz
+ *         https://www.boost.org/doc/libs/release/doc/html/poly_collection.html
+ */
+
+using Particles = std::vector<int>;
+
+// Counts constructions and moves of its owner, to check that emplace builds
+// each action in place (see 2025-06/07_special_members_tracer.cpp for more)
+struct ConstructionCounter {
+  inline static std::size_t constructions = 0;
+  inline static std::size_t moves = 0;
+
+  ConstructionCounter() noexcept { ++constructions; }
+  ConstructionCounter(ConstructionCounter&&) noexcept { ++moves; }
+  ConstructionCounter& operator=(ConstructionCounter&&) noexcept {
+    ++moves;
+    return *this;
+  }
+};
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied, but it can be moved by derived classes
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  explicit Action(std::initializer_list<int> ids) : particles_{ids} {}
+  explicit Action(std::span<const int> ids)
+      : particles_{ids.begin(), ids.end()} {}
+  template <std::input_iterator It>
+  Action(It first, It last) : particles_(first, last) {}
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform() const = 0;
+
+ protected:
+  // Needed by the segments of ActionCollection to grow, but protected to
+  // avoid slicing through a reference to the base class
+  Action(Action&&) = default;
+  Action& operator=(Action&&) = default;
+
+ private:
+  Particles particles_;
+  ConstructionCounter counter_{};
+};
+
+class ScatterAction final : public Action {
+ public:
+  using Action::Action;
+  void perform() const override {
+    if (const auto& p = particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+};
+
+class FluidizationAction final : public Action {
+ public:
+  using Action::Action;
+  void perform() const override {
+    if (const auto& p = particles(); p.size() > 0) {
+      std::cout << "Particle " << p.back() << " will be melt.\n";
+    }
+  }
+};
+
+class DecayAction final : public Action {
+ public:
+  using Action::Action;
+  void perform() const override {
+    std::cout << "Particle(s) ";
+    for (auto p : particles()) {
+      std::cout << p << " ";
+    }
+    std::cout << "will be decayed.\n";
+  }
+};
+
+template <typename... ActionTypes>
+class ActionCollection {
+  static_assert((std::is_base_of_v<Action, ActionTypes> && ...),
+                "ActionCollection can only store types derived from Action");
+  static_assert((std::is_final_v<ActionTypes> && ...),
+                "Segment types must be final for calls to be devirtualized");
+
+ public:
+  using size_type = std::size_t;
+
+  // Arguments are forwarded as they were given, so that the action is the
+  // only object constructed (rvalues are moved, lvalues are copied)
+  template <typename T, typename... Args>
+  T& emplace(Args&&... args) {
+    return segment<T>().emplace_back(std::forward<Args>(args)...);
+  }
+
+  // A braced list cannot be deduced by the overload above
+  template <typename T>
+  T& emplace(std::initializer_list<int> ids) {
+    return segment<T>().emplace_back(ids);
+  }
+
+  template <typename T>
+  const std::vector<T>& segment() const {
+    return std::get<std::vector<T>>(segments_);
+  }
+
+  template <typename T>
+  void reserve(size_type n) {
+    segment<T>().reserve(n);
+  }
+
+  size_type size() const noexcept {
+    return (segment<ActionTypes>().size() + ... + 0);
+  }
+  bool empty() const noexcept { return size() == 0; }
+
+  // Call f on every action, one segment after the other. The argument passed
+  // to f has the concrete (static) type of the segment.
+  template <typename F>
+  void for_each(F&& f) const {
+    (for_each_in_segment(segment<ActionTypes>(), f), ...);
+  }
+
+ private:
+  template <typename T>
+  std::vector<T>& segment() {
+    return std::get<std::vector<T>>(segments_);
+  }
+
+  template <typename T, typename F>
+  static void for_each_in_segment(const std::vector<T>& actions, F& f) {
+    for (const auto& action : actions) {
+      f(action);
+    }
+  }
+
+  std::tuple<std::vector<ActionTypes>...> segments_{};
+};
+
+using Actions = ActionCollection<ScatterAction, FluidizationAction, DecayAction>;
+
+void perform_all_actions(const Actions& actions) {
+  // The lambda is instantiated once per segment type, so that here perform()
+  // is called on a final class and can be inlined by the compiler
+  actions.for_each([](const auto& action) { action.perform(); });
+}
+
+int main() {
+  // Creating actions directly in their segment, from any source of ids
+  const int ids[] = {2, 22, 222, 66, 77};
+  Particles p4 = {3, 33, 333};
+  Actions actions{};
+  // Segments must not grow, or they move their actions
+  actions.reserve<ScatterAction>(2);
+  actions.reserve<FluidizationAction>(1);
+  actions.reserve<DecayAction>(1);
+  actions.emplace<ScatterAction>({1, 11, 111});
+  actions.emplace<FluidizationAction>(std::span{ids}.first(3));
+  actions.emplace<DecayAction>(std::begin(ids) + 3, std::end(ids));
+  actions.emplace<ScatterAction>(std::move(p4));
+  std::cout << ConstructionCounter::constructions << " actions constructed, "
+            << ConstructionCounter::moves << " moved.\n";
+
+  // Performing actions (note that they are grouped by type)
+  std::cout << "PERFORM " << actions.size() << " actions:\n";
+  perform_all_actions(actions);
+}
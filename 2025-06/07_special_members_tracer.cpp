@@ -0,0 +1,346 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Instead of printing from each special member function as in 07.cpp (via
+ * I_am), count how often each of them is called, per type.
+ *
+ *  1) Traced<T> is a CRTP mixin, a base class of T
+ *      ↳ its special member functions increment atomic counters of T;
+ *      ↳ they run if those of T are defaulted (or explicitly call the ones of
+ *        the base), nothing else is needed in T.
+ *  2) Counted<T> wraps types one cannot change, e.g. std::vector<int>
+ *      ↳ it derives from T and inherits all its constructors;
+ *      ↳ converting from a T is explicit, from a const T& it counts as copy.
+ *  3) Checking, e.g. in tests, that a block does not copy
+ *      ↳ ASSERT_NO_COPIES(T) aborts at the end of the enclosing scope if any
+ *        object of type T was copied meanwhile;
+ *      ↳ SpecialMembersProbe<T> gives the counts since it was created;
+ *      ↳ counters are global per type, other threads contribute, too.
+ *  4) Compiling with -DSPECIAL_MEMBERS_TRACING=0 removes all of it
+ *      ↳ Traced<T> is an empty aggregate without any declared constructor, so
+ *        it takes no space and does not change any type trait of T (checked
+ *        by static_assert).
+ */
+
+#ifndef SPECIAL_MEMBERS_TRACING
+#define SPECIAL_MEMBERS_TRACING 1
+#endif
+
+// Taken from https://stackoverflow.com/a/56766138/14967071
+template <typename T>
+constexpr auto type_name() {
+  std::string_view name, prefix, suffix;
+#ifdef __clang__
+  name = __PRETTY_FUNCTION__;
+  prefix = "auto type_name() [T = ";
+  suffix = "]";
+#elif defined(__GNUC__)
+  name = __PRETTY_FUNCTION__;
+  prefix = "constexpr auto type_name() [with T = ";
+  suffix = "]";
+#elif defined(_MSC_VER)
+  name = __FUNCSIG__;
+  prefix = "auto __cdecl type_name<";
+  suffix = ">(void)";
+#endif
+  name.remove_prefix(prefix.size());
+  name.remove_suffix(suffix.size());
+  return name;
+}
+
+// Constructions are all the ones which are neither copies nor moves
+struct SpecialMemberCounts {
+  std::uint64_t constructions = 0;
+  std::uint64_t copy_constructions = 0;
+  std::uint64_t copy_assignments = 0;
+  std::uint64_t move_constructions = 0;
+  std::uint64_t move_assignments = 0;
+  std::uint64_t destructions = 0;
+
+  std::uint64_t copies() const { return copy_constructions + copy_assignments; }
+  std::uint64_t moves() const { return move_constructions + move_assignments; }
+
+  SpecialMemberCounts operator-(const SpecialMemberCounts& other) const {
+    return {constructions - other.constructions,
+            copy_constructions - other.copy_constructions,
+            copy_assignments - other.copy_assignments,
+            move_constructions - other.move_constructions,
+            move_assignments - other.move_assignments,
+            destructions - other.destructions};
+  }
+};
+
+template <typename T>
+class SpecialMemberCounters {
+ public:
+  void constructed() { increment(constructions_); }
+  void copy_constructed() { increment(copy_constructions_); }
+  void copy_assigned() { increment(copy_assignments_); }
+  void move_constructed() { increment(move_constructions_); }
+  void move_assigned() { increment(move_assignments_); }
+  void destructed() { increment(destructions_); }
+
+  SpecialMemberCounts load() const {
+    auto get = [](const Counter& c) {
+      return c.load(std::memory_order_relaxed);
+    };
+    return {get(constructions_),      get(copy_constructions_),
+            get(copy_assignments_),   get(move_constructions_),
+            get(move_assignments_),   get(destructions_)};
+  }
+
+ private:
+  using Counter = std::atomic<std::uint64_t>;
+
+  static void increment(Counter& counter) {
+    counter.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Counter constructions_{0};
+  Counter copy_constructions_{0};
+  Counter copy_assignments_{0};
+  Counter move_constructions_{0};
+  Counter move_assignments_{0};
+  Counter destructions_{0};
+};
+
+template <typename T>
+inline SpecialMemberCounters<T> special_member_counters{};
+
+template <typename T>
+SpecialMemberCounts special_member_counts() {
+  return special_member_counters<T>.load();
+}
+
+#if SPECIAL_MEMBERS_TRACING
+
+template <typename T>
+class Traced {
+ public:
+  Traced() noexcept { special_member_counters<T>.constructed(); }
+  Traced(const Traced&) noexcept {
+    special_member_counters<T>.copy_constructed();
+  }
+  Traced& operator=(const Traced&) noexcept {
+    special_member_counters<T>.copy_assigned();
+    return *this;
+  }
+  Traced(Traced&&) noexcept { special_member_counters<T>.move_constructed(); }
+  Traced& operator=(Traced&&) noexcept {
+    special_member_counters<T>.move_assigned();
+    return *this;
+  }
+  ~Traced() { special_member_counters<T>.destructed(); }
+
+ protected:
+  // For constructors of T copying from another type, e.g. a T(const U&)
+  struct copy_tag {};
+  explicit Traced(copy_tag) noexcept {
+    special_member_counters<T>.copy_constructed();
+  }
+};
+
+#else
+
+template <typename T>
+class Traced {};
+
+static_assert(std::is_empty_v<Traced<int>> && std::is_aggregate_v<Traced<int>>);
+static_assert(std::is_trivial_v<Traced<int>> &&
+              std::is_trivially_copyable_v<Traced<int>>);
+
+#endif
+
+// For types that cannot derive from Traced themselves
+template <typename T>
+class Counted : public T, private Traced<Counted<T>> {
+  using Base = Traced<Counted<T>>;
+
+ public:
+  using T::T;
+  Counted() = default;
+#if SPECIAL_MEMBERS_TRACING
+  explicit Counted(const T& t) : T(t), Base(typename Base::copy_tag{}) {}
+#else
+  explicit Counted(const T& t) : T(t) {}
+#endif
+  explicit Counted(T&& t) : T(std::move(t)) {}
+};
+
+#if !SPECIAL_MEMBERS_TRACING
+static_assert(sizeof(Counted<std::vector<int>>) == sizeof(std::vector<int>));
+#endif
+
+// Counts of the special member functions of T since the probe was created
+template <typename T>
+class SpecialMembersProbe {
+ public:
+  SpecialMemberCounts delta() const {
+    return special_member_counts<T>() - start_;
+  }
+
+ private:
+  SpecialMemberCounts start_ = special_member_counts<T>();
+};
+
+template <typename T>
+class NoCopiesGuard {
+ public:
+  NoCopiesGuard(const char* file, int line) : file_{file}, line_{line} {}
+  NoCopiesGuard(const NoCopiesGuard&) = delete;
+  NoCopiesGuard& operator=(const NoCopiesGuard&) = delete;
+  ~NoCopiesGuard() {
+    if (const auto copies = probe_.delta().copies(); copies > 0) {
+      std::cerr << file_ << ":" << line_ << ": " << copies << " unexpected "
+                << "cop" << (copies == 1 ? "y" : "ies") << " of "
+                << type_name<T>() << "\n";
+      std::abort();
+    }
+  }
+
+ private:
+  const char* file_;
+  int line_;
+  SpecialMembersProbe<T> probe_{};
+};
+
+#define SPECIAL_MEMBERS_CONCATENATE_IMPL(a, b) a##b
+#define SPECIAL_MEMBERS_CONCATENATE(a, b) SPECIAL_MEMBERS_CONCATENATE_IMPL(a, b)
+#if SPECIAL_MEMBERS_TRACING
+#define ASSERT_NO_COPIES(T)                                         \
+  NoCopiesGuard<T> SPECIAL_MEMBERS_CONCATENATE(no_copies_guard_, __LINE__) { \
+    __FILE__, __LINE__                                                      \
+  }
+#else
+#define ASSERT_NO_COPIES(T) static_cast<void>(0)
+#endif
+
+template <typename T>
+void print_counts() {
+  const auto c = special_member_counts<T>();
+  std::cout << type_name<T>() << ": " << c.constructions << " constructed, "
+            << c.copy_constructions << "+" << c.copy_assignments
+            << " copied, " << c.move_constructions << "+" << c.move_assignments
+            << " moved, " << c.destructions << " destructed\n";
+}
+
+//================================ EXAMPLES ===================================
+
+struct Base : Traced<Base> {
+  virtual ~Base() = default;
+  Base() = default;
+  Base(const Base&) = default;
+  Base& operator=(const Base&) = default;
+  Base(Base&&) = default;
+  Base& operator=(Base&&) = default;
+
+  void talk() const { std::cout << s_base << "\n"; }
+
+ private:
+  std::string s_base{"Hi"};
+};
+
+struct Derived final : public Base, Traced<Derived> {
+  void talk() const { std::cout << s_derived << "\n"; }
+
+ private:
+  std::string s_derived{"Bye"};
+};
+
+void chat(const Base& b) {
+  std::cout << "Chatting: ";
+  b.talk();
+}
+
+void danger_chat(Base b) {
+  std::cout << "Danger chatting: ";
+  b.talk();
+}
+
+// Actions as in 09_start.cpp, with particles whose copies are counted
+using Particles = Counted<std::vector<int>>;
+
+class Action {
+ public:
+  explicit Action(Particles p) : particles_{std::move(p)} {}
+  virtual ~Action() = default;
+  std::span<const int> particles() const { return particles_; }
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    if (auto p = particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+};
+
+int main(int argc, char*[]) {
+  {
+    Derived d{};
+    chat(d);
+    danger_chat(d);  // slicing, Base is copied
+  }
+#if SPECIAL_MEMBERS_TRACING
+  print_counts<Base>();
+  print_counts<Derived>();
+#endif
+
+  // This block must not copy any Particles
+  Particles p1 = {1, 11, 111}, p2 = {2, 22, 222};
+  std::vector<std::unique_ptr<Action>> actions{};
+  {
+    ASSERT_NO_COPIES(Particles);
+    actions.emplace_back(std::make_unique<ScatterAction>(std::move(p1)));
+    actions.emplace_back(std::make_unique<ScatterAction>(std::move(p2)));
+    // The following would abort at the end of the block:
+    // actions.emplace_back(std::make_unique<ScatterAction>(p2));
+  }
+  std::cout << "PERFORM:\n";
+  for (const auto& action : actions) {
+    action->perform();
+  }
+
+  // Converting from a plain vector copies it, and it is counted as copy
+  const std::vector<int> ids = {3, 33, 333};
+  SpecialMembersProbe<Particles> probe{};
+  Particles p3{ids};
+#if SPECIAL_MEMBERS_TRACING
+  std::cout << "Particles from a vector: " << probe.delta().copies()
+            << " copy\n";
+  print_counts<Particles>();
+#endif
+
+  // Run with any argument to see ASSERT_NO_COPIES abort
+  if (argc > 1) {
+    ASSERT_NO_COPIES(Particles);
+    Particles p4{ids};
+  }
+}
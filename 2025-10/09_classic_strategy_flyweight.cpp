@@ -0,0 +1,186 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Same strategies as in 09_classic_strategy.cpp, but shared among actions
+ * (flyweight design pattern) instead of being owned by each action.
+ *
+ *  1) A StrategyRegistry owns all strategy instances
+ *      ↳ shared<S>() returns the one instance of the stateless strategy S,
+ *        created the first time it is asked for;
+ *      ↳ add<S>(args...) creates a new instance, e.g. of a stateful strategy
+ *        that needs constructor arguments.
+ *  2) Actions refer to an immutable strategy through a const reference
+ *      ↳ creating an action does not allocate any strategy;
+ *      ↳ the registry must outlive all actions using its strategies.
+ */
+
+class Action;
+class ScatterAction;
+class FluidizationAction;
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class PerformStrategy {
+ public:
+  virtual ~PerformStrategy() {}
+  virtual void perform(const ScatterAction&) const = 0;
+  virtual void perform(const FluidizationAction&) const = 0;
+};
+
+class StrategyRegistry {
+ public:
+  StrategyRegistry() = default;
+  // Rule of 5: strategies are owned uniquely, the registry can only be moved
+  StrategyRegistry(const StrategyRegistry&) = delete;
+  StrategyRegistry& operator=(const StrategyRegistry&) = delete;
+  StrategyRegistry(StrategyRegistry&&) = default;
+  StrategyRegistry& operator=(StrategyRegistry&&) = default;
+  ~StrategyRegistry() = default;
+
+  // The shared instance of the (stateless) strategy S
+  template <typename S>
+  const PerformStrategy& shared() {
+    if (auto it = shared_index_.find(typeid(S)); it != shared_index_.end()) {
+      return *strategies_[it->second];
+    }
+    // Stored first, so that the index never refers to a missing strategy
+    strategies_.push_back(std::make_unique<S>());
+    shared_index_.emplace(typeid(S), strategies_.size() - 1);
+    return *strategies_.back();
+  }
+
+  // A new instance of the strategy S, owned by the registry
+  template <typename S, typename... Args>
+  const PerformStrategy& add(Args&&... args) {
+    strategies_.push_back(std::make_unique<S>(std::forward<Args>(args)...));
+    return *strategies_.back();
+  }
+
+  std::size_t size() const noexcept { return strategies_.size(); }
+
+ private:
+  std::vector<std::unique_ptr<const PerformStrategy>> strategies_{};
+  std::unordered_map<std::type_index, std::size_t> shared_index_{};
+};
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p, const PerformStrategy& ps)
+      : Action{std::move(p)}, performer_{ps} {}
+  void perform() const override { performer_.perform(*this); }
+
+ private:
+  const PerformStrategy& performer_;
+};
+
+class FluidizationAction : public Action {
+ public:
+  explicit FluidizationAction(Particles p, const PerformStrategy& ps)
+      : Action{std::move(p)}, performer_{ps} {}
+  void perform() const override { performer_.perform(*this); }
+
+ private:
+  const PerformStrategy& performer_;
+};
+
+class PerformStandardStrategy : public PerformStrategy {
+ public:
+  void perform(ScatterAction const& action) const override {
+    if (const auto& p = action.particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+  void perform(FluidizationAction const& action) const override {
+    if (const auto& p = action.particles(); p.size() > 0) {
+      std::cout << "Particle " << p.back() << " will be melt.\n";
+    }
+  }
+};
+
+// A strategy with a state, which still can be shared among many actions
+class PerformColoredStrategy : public PerformStrategy {
+ public:
+  explicit PerformColoredStrategy(std::string color)
+      : color_{std::move(color)} {}
+  void perform(ScatterAction const& action) const override {
+    if (const auto& p = action.particles(); p.size() > 1) {
+      std::cout << color_ << "Scattering between " << p[0] << " and " << p[1]
+                << ".\e[0m\n";
+    }
+  }
+  void perform(FluidizationAction const& action) const override {
+    if (const auto& p = action.particles(); p.size() > 0) {
+      std::cout << color_ << "Particle " << p.back() << " will be melt.\e[0m\n";
+    }
+  }
+
+ private:
+  std::string color_;
+};
+
+void perform_all_actions(const Actions& actions) {
+  for (const auto& action : actions) {
+    action->perform();
+  }
+}
+
+int main() {
+  // The registry is declared first, so that it outlives the actions
+  StrategyRegistry strategies{};
+  const auto& red = strategies.add<PerformColoredStrategy>("\e[91m");
+
+  // Creating actions
+  Particles p1 = {1, 11, 111}, p2 = {2, 22, 222}, p3 = {3, 33, 333};
+  Actions actions{};
+  actions.emplace_back(std::make_unique<ScatterAction>(
+      std::move(p1), strategies.shared<PerformStandardStrategy>()));
+  actions.emplace_back(std::make_unique<FluidizationAction>(
+      std::move(p2), strategies.shared<PerformStandardStrategy>()));
+  actions.emplace_back(std::make_unique<ScatterAction>(std::move(p3), red));
+
+  // Performing actions
+  std::cout << "PERFORM:\n";
+  perform_all_actions(actions);
+  std::cout << actions.size() << " actions share " << strategies.size()
+            << " strategies.\n";
+}
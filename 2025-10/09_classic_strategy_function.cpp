@@ -9,8 +9,10 @@
  *===================================================
  */
 
+#include <functional>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <vector>
 
 class Action;
@@ -35,7 +37,7 @@ class Action {
   virtual ~Action() = default;
 
   // External read-access to particles
-  const Particles& particles() const { return particles_; }
+  std::span<const int> particles() const { return particles_; }
 
   // Operations
   virtual void perform() const = 0;
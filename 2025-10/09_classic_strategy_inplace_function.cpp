@@ -0,0 +1,301 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Same strategies as in 09_classic_strategy_function.cpp, but stored in an
+ * InplaceFunction instead of a std::function.
+ *
+ *  1) InplaceFunction<Signature, Capacity>
+ *      ↳ the callable is always stored in an inline buffer of fixed size, it
+ *        never allocates (a std::function may, if the callable is large);
+ *      ↳ callables that do not fit are rejected at compile time;
+ *      ↳ move-only, hence no requirement on the callable to be copyable;
+ *      ↳ type erasure through a static table of function pointers;
+ *      ↳ calling an empty one throws std::bad_function_call, as std::function
+ *        does, at no cost for the non-empty case (empty ones have a table).
+ *  2) FunctionRef<Signature>
+ *      ↳ non-owning reference to any callable, two pointers in size;
+ *      ↳ meant for function parameters, where the callable outlives the call;
+ *      ↳ never store it, it would dangle as soon as the callable goes away!
+ */
+
+template <typename Signature, std::size_t Capacity = 2 * sizeof(void*)>
+class InplaceFunction;
+
+template <typename R, typename... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+ public:
+  InplaceFunction() noexcept = default;
+
+  template <typename F>
+    requires(!std::is_same_v<std::remove_cvref_t<F>, InplaceFunction> &&
+             std::is_invocable_r_v<R, const std::remove_cvref_t<F>&, Args...>)
+  InplaceFunction(F&& f) {
+    using Callable = std::remove_cvref_t<F>;
+    static_assert(sizeof(Callable) <= Capacity,
+                  "Callable too large for the inline buffer of InplaceFunction");
+    static_assert(alignof(Callable) <= alignof(std::max_align_t),
+                  "Callable over-aligned for the buffer of InplaceFunction");
+    static_assert(std::is_nothrow_move_constructible_v<Callable>,
+                  "Callable stored in InplaceFunction must be nothrow movable");
+    ::new (static_cast<void*>(storage_)) Callable(std::forward<F>(f));
+    vtable_ = &vtable_for<Callable>;
+  }
+
+  // Rule of 5: InplaceFunction can be moved but not copied
+  InplaceFunction(const InplaceFunction&) = delete;
+  InplaceFunction& operator=(const InplaceFunction&) = delete;
+  InplaceFunction(InplaceFunction&& other) noexcept { move_from(other); }
+  InplaceFunction& operator=(InplaceFunction&& other) noexcept {
+    if (this != &other) {
+      reset();
+      move_from(other);
+    }
+    return *this;
+  }
+  ~InplaceFunction() { reset(); }
+
+  R operator()(Args... args) const {
+    return vtable_->invoke(storage_, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const noexcept { return vtable_ != &empty_vtable; }
+
+ private:
+  struct VTable {
+    R (*invoke)(const std::byte*, Args&&...);
+    void (*move)(std::byte* destination, std::byte* source) noexcept;
+    void (*destroy)(std::byte*) noexcept;
+  };
+
+  static constexpr VTable empty_vtable{
+      [](const std::byte*, Args&&...) -> R { throw std::bad_function_call{}; },
+      [](std::byte*, std::byte*) noexcept {}, [](std::byte*) noexcept {}};
+
+  template <typename Callable>
+  static constexpr VTable vtable_for{
+      [](const std::byte* storage, Args&&... args) -> R {
+        return (*std::launder(reinterpret_cast<const Callable*>(storage)))(
+            std::forward<Args>(args)...);
+      },
+      [](std::byte* destination, std::byte* source) noexcept {
+        auto* callable = std::launder(reinterpret_cast<Callable*>(source));
+        ::new (static_cast<void*>(destination)) Callable(std::move(*callable));
+        callable->~Callable();
+      },
+      [](std::byte* storage) noexcept {
+        std::launder(reinterpret_cast<Callable*>(storage))->~Callable();
+      }};
+
+  void move_from(InplaceFunction& other) noexcept {
+    other.vtable_->move(storage_, other.storage_);
+    vtable_ = std::exchange(other.vtable_, &empty_vtable);
+  }
+
+  void reset() noexcept {
+    std::exchange(vtable_, &empty_vtable)->destroy(storage_);
+  }
+
+  alignas(std::max_align_t) std::byte storage_[Capacity];
+  const VTable* vtable_ = &empty_vtable;
+};
+
+template <typename Signature>
+class FunctionRef;
+
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+ public:
+  template <typename F>
+    requires(!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> &&
+             std::is_invocable_r_v<R, F&, Args...>)
+  FunctionRef(F&& f) noexcept
+      : invoke_{&invoke<std::remove_reference_t<F>>} {
+    if constexpr (std::is_function_v<std::remove_reference_t<F>>) {
+      bound_.function = reinterpret_cast<void (*)()>(std::addressof(f));
+    } else {
+      bound_.object =
+          const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+    }
+  }
+
+  R operator()(Args... args) const {
+    return invoke_(bound_, std::forward<Args>(args)...);
+  }
+
+ private:
+  // Pointers to functions do not convert to void*, they get their own member
+  union Bound {
+    void* object;
+    void (*function)();
+  };
+
+  template <typename F>
+  static R invoke(Bound bound, Args&&... args) {
+    if constexpr (std::is_function_v<F>) {
+      return reinterpret_cast<F*>(bound.function)(std::forward<Args>(args)...);
+    } else {
+      return (*static_cast<F*>(bound.object))(std::forward<Args>(args)...);
+    }
+  }
+
+  Bound bound_;
+  R (*invoke_)(Bound, Args&&...);
+};
+
+class Action;
+class ScatterAction;
+class FluidizationAction;
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+using PerformScatterStrategy = InplaceFunction<void(ScatterAction const&)>;
+using PerformFluidizationStrategy =
+    InplaceFunction<void(FluidizationAction const&)>;
+// Callables not matching the signature are not candidates at all
+static_assert(!std::is_constructible_v<PerformScatterStrategy,
+                                       void (*)(FluidizationAction const&)>);
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p, PerformScatterStrategy ps)
+      : Action{std::move(p)}, performer_{std::move(ps)} {}
+  void perform() const override { performer_(*this); }
+
+ private:
+  PerformScatterStrategy performer_{};
+};
+
+class FluidizationAction : public Action {
+ public:
+  explicit FluidizationAction(Particles p, PerformFluidizationStrategy ps)
+      : Action{std::move(p)}, performer_{std::move(ps)} {}
+  void perform() const override { performer_(*this); }
+
+ private:
+  PerformFluidizationStrategy performer_{};
+};
+
+class PerformStandardStrategy {
+ public:
+  void operator()(ScatterAction const& action) const {
+    if (const auto& p = action.particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+  void operator()(FluidizationAction const& action) const {
+    if (const auto& p = action.particles(); p.size() > 0) {
+      std::cout << "Particle " << p.back() << " will be melt.\n";
+    }
+  }
+};
+
+class PerformCyanStrategy {
+ public:
+  void operator()(FluidizationAction const& action) const {
+    if (const auto& p = action.particles(); p.size() > 0) {
+      std::cout << "\e[96mParticle " << p.back() << " will be melt.\e[0m\n";
+    }
+  }
+};
+
+class PerformRedStrategy {
+ public:
+  void operator()(ScatterAction const& action) const {
+    if (const auto& p = action.particles(); p.size() > 1) {
+      std::cout << "\e[91mScattering between " << p[0] << " and " << p[1]
+                << ".\e[0m\n";
+    }
+  }
+};
+
+void perform_all_actions(const Actions& actions) {
+  for (const auto& action : actions) {
+    action->perform();
+  }
+}
+
+void do_on_all_actions(const Actions& actions,
+                       FunctionRef<void(const Action&)> operation) {
+  for (const auto& action : actions) {
+    operation(*action);
+  }
+}
+
+void print_number_of_particles(const Action& action) {
+  std::cout << ' ' << action.particles().size();
+}
+
+int main() {
+  // Creating actions, stateful lambdas are fine as long as they fit inline
+  Particles p1 = {1, 11, 111}, p2 = {2, 22, 222}, p3 = {3, 33, 333};
+  std::string_view magenta = "\e[95m";
+  Actions actions{};
+  actions.emplace_back(std::make_unique<ScatterAction>(
+      std::move(p1), PerformRedStrategy{}));
+  actions.emplace_back(std::make_unique<FluidizationAction>(
+      std::move(p2), PerformCyanStrategy{}));
+  actions.emplace_back(std::make_unique<ScatterAction>(
+      std::move(p3), [magenta](ScatterAction const& action) {
+        std::cout << magenta << "Scattering " << action.particles().size()
+                  << " particles.\e[0m\n";
+      }));
+  // The following would not compile, since the lambda is too large:
+  // std::string_view a, b;
+  // PerformScatterStrategy s = [a, b, magenta](ScatterAction const&) {};
+
+  // Performing actions
+  std::cout << "PERFORM:\n";
+  perform_all_actions(actions);
+
+  // Non-owning callables for call sites
+  std::size_t number_of_particles = 0;
+  do_on_all_actions(actions, [&number_of_particles](const Action& action) {
+    number_of_particles += action.particles().size();
+  });
+  std::cout << "Actions involve " << number_of_particles << " particles.\n";
+  // Plain functions can be referred to as well
+  std::cout << "Particles per action:";
+  do_on_all_actions(actions, print_number_of_particles);
+  std::cout << '\n';
+}
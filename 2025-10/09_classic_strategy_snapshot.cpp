@@ -0,0 +1,550 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Same shared strategies as in 09_classic_strategy_flyweight.cpp, with the
+ * whole set of pending actions saved to a snapshot file and restored from it.
+ *
+ *  1) ActionState owns all pending actions and their particles
+ *      ↳ particle ids of all actions are stored one after the other in a
+ *        single buffer, plus the offset where each action starts;
+ *      ↳ an action only knows the state and its own index.
+ *  2) The snapshot is a plain image of that state
+ *      ↳ a header, a table with one fixed-size entry per action (its type
+ *        and the index of its strategy in the StrategyRegistry), the offsets
+ *        and the particle ids, all written with a handful of write calls.
+ *  3) Restoring memory-maps the file, nothing is parsed
+ *      ↳ offsets and particle ids are used directly from the mapping;
+ *      ↳ only the action objects are created, looking up their strategy by
+ *        index (the strategy pointers are "fixed up");
+ *      ↳ adding actions to a restored state first copies the mapped buffers,
+ *        which happens once.
+ *  4) Strategies are identified by their index in the registry
+ *      ↳ the restarted program must register them in the same order, which
+ *        is checked as far as possible (number of strategies).
+ */
+
+class Action;
+class ScatterAction;
+class FluidizationAction;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class PerformStrategy {
+ public:
+  virtual ~PerformStrategy() {}
+  virtual void perform(const ScatterAction&) const = 0;
+  virtual void perform(const FluidizationAction&) const = 0;
+};
+
+class StrategyRegistry {
+ public:
+  StrategyRegistry() = default;
+  // Rule of 5: strategies are owned uniquely, the registry can only be moved
+  StrategyRegistry(const StrategyRegistry&) = delete;
+  StrategyRegistry& operator=(const StrategyRegistry&) = delete;
+  StrategyRegistry(StrategyRegistry&&) = default;
+  StrategyRegistry& operator=(StrategyRegistry&&) = default;
+  ~StrategyRegistry() = default;
+
+  // The shared instance of the (stateless) strategy S
+  template <typename S>
+  const PerformStrategy& shared() {
+    if (auto it = shared_index_.find(typeid(S)); it != shared_index_.end()) {
+      return *strategies_[it->second];
+    }
+    // Stored first, so that the index never refers to a missing strategy
+    const auto& strategy = store(std::make_unique<S>());
+    shared_index_.emplace(typeid(S), strategies_.size() - 1);
+    return strategy;
+  }
+
+  // A new instance of the strategy S, owned by the registry
+  template <typename S, typename... Args>
+  const PerformStrategy& add(Args&&... args) {
+    return store(std::make_unique<S>(std::forward<Args>(args)...));
+  }
+
+  // Strategies are identified by their registration order
+  std::size_t index_of(const PerformStrategy& strategy) const {
+    return index_of_.at(&strategy);
+  }
+  const PerformStrategy& at(std::size_t index) const {
+    return *strategies_.at(index);
+  }
+
+  std::size_t size() const noexcept { return strategies_.size(); }
+
+ private:
+  const PerformStrategy& store(std::unique_ptr<const PerformStrategy> s) {
+    strategies_.push_back(std::move(s));
+    try {
+      index_of_.emplace(strategies_.back().get(), strategies_.size() - 1);
+    } catch (...) {
+      strategies_.pop_back();
+      throw;
+    }
+    return *strategies_.back();
+  }
+
+  std::vector<std::unique_ptr<const PerformStrategy>> strategies_{};
+  std::unordered_map<std::type_index, std::size_t> shared_index_{};
+  std::unordered_map<const PerformStrategy*, std::size_t> index_of_{};
+};
+
+// Read-only memory mapping of a whole file
+class FileMapping {
+ public:
+  FileMapping() = default;
+  explicit FileMapping(const std::filesystem::path& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::system_error{errno, std::generic_category(),
+                              "Cannot open " + path.string()};
+    }
+    struct stat status{};
+    if (::fstat(fd, &status) != 0) {
+      const int error = errno;
+      ::close(fd);
+      throw std::system_error{error, std::generic_category(),
+                              "Cannot stat " + path.string()};
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ > 0) {
+      void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error{error, std::generic_category(),
+                                "Cannot map " + path.string()};
+      }
+      data_ = static_cast<const std::byte*>(data);
+    }
+    ::close(fd);  // the mapping stays valid
+  }
+  // Rule of 5: the mapping is owned uniquely, it can only be moved
+  FileMapping(const FileMapping&) = delete;
+  FileMapping& operator=(const FileMapping&) = delete;
+  FileMapping(FileMapping&& other) noexcept
+      : data_{std::exchange(other.data_, nullptr)},
+        size_{std::exchange(other.size_, 0)} {}
+  FileMapping& operator=(FileMapping&& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    return *this;
+  }
+  ~FileMapping() {
+    if (data_) {
+      ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+  }
+
+  std::span<const std::byte> bytes() const noexcept { return {data_, size_}; }
+
+ private:
+  const std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+enum class ActionType : std::uint32_t { scatter = 0, fluidization = 1 };
+
+class ActionState;
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  Action(const ActionState& state, std::size_t index)
+      : state_{state}, index_{index} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles, stored in the state
+  std::span<const int> particles() const;
+
+  // Operations
+  virtual void perform() const = 0;
+  virtual ActionType type() const = 0;
+  virtual const PerformStrategy& strategy() const = 0;
+
+ private:
+  const ActionState& state_;
+  std::size_t index_;
+};
+
+class ScatterAction : public Action {
+ public:
+  ScatterAction(const ActionState& state, std::size_t index,
+                const PerformStrategy& ps)
+      : Action{state, index}, performer_{ps} {}
+  void perform() const override { performer_.perform(*this); }
+  ActionType type() const override { return ActionType::scatter; }
+  const PerformStrategy& strategy() const override { return performer_; }
+
+ private:
+  const PerformStrategy& performer_;
+};
+
+class FluidizationAction : public Action {
+ public:
+  FluidizationAction(const ActionState& state, std::size_t index,
+                     const PerformStrategy& ps)
+      : Action{state, index}, performer_{ps} {}
+  void perform() const override { performer_.perform(*this); }
+  ActionType type() const override { return ActionType::fluidization; }
+  const PerformStrategy& strategy() const override { return performer_; }
+
+ private:
+  const PerformStrategy& performer_;
+};
+
+class ActionState {
+ public:
+  explicit ActionState(const StrategyRegistry& strategies)
+      : strategies_{strategies} {}
+  // Restore the state from a snapshot written by save
+  ActionState(const StrategyRegistry& strategies,
+              const std::filesystem::path& snapshot)
+      : strategies_{strategies}, mapping_{snapshot} {
+    restore();
+  }
+  // Rule of 5: actions refer to the state, which cannot be copied or moved
+  ActionState(const ActionState&) = delete;
+  ActionState& operator=(const ActionState&) = delete;
+  ActionState(ActionState&&) = delete;
+  ActionState& operator=(ActionState&&) = delete;
+  ~ActionState() = default;
+
+  // The particles may be the ones of an action of this state, which live in
+  // the mapping or in owned_ids_ and are unmapped or reallocated below, hence
+  // they are copied first. All allocations happen before anything changes.
+  template <typename T>
+  T& emplace(std::span<const int> particles, const PerformStrategy& strategy) {
+    const std::vector<int> ids(particles.begin(), particles.end());
+    auto action = std::make_unique<T>(*this, actions_.size(), strategy);
+    T& reference = *action;
+    make_owned();
+    make_room(owned_ids_, ids.size());
+    make_room(owned_offsets_, 1);
+    make_room(actions_, 1);
+    owned_ids_.insert(owned_ids_.end(), ids.begin(), ids.end());
+    owned_offsets_.push_back(owned_ids_.size());
+    actions_.push_back(std::move(action));
+    offsets_ = owned_offsets_;
+    ids_ = owned_ids_;
+    return reference;
+  }
+
+  template <typename T>
+  T& emplace(std::initializer_list<int> particles,
+             const PerformStrategy& strategy) {
+    return emplace<T>(std::span<const int>{particles.begin(), particles.size()},
+                      strategy);
+  }
+
+  std::span<const int> particles(std::size_t index) const {
+    return ids_.subspan(offsets_[index], offsets_[index + 1] - offsets_[index]);
+  }
+
+  const Actions& actions() const noexcept { return actions_; }
+  bool is_mapped() const noexcept { return !mapping_.bytes().empty(); }
+
+  void save(const std::filesystem::path& snapshot) const {
+    std::vector<Entry> entries(actions_.size());
+    for (std::size_t i = 0; i < actions_.size(); ++i) {
+      entries[i] = {static_cast<std::uint32_t>(actions_[i]->type()),
+                    static_cast<std::uint32_t>(
+                        strategies_.index_of(actions_[i]->strategy()))};
+    }
+    const Header header = make_header(actions_.size(), ids_.size());
+    // Written aside and renamed, since the state may be mapped from snapshot
+    auto temporary = snapshot;
+    temporary += ".tmp";
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> file{
+        std::fopen(temporary.c_str(), "wb"), &std::fclose};
+    if (!file) {
+      throw std::system_error{errno, std::generic_category(),
+                              "Cannot open " + temporary.string()};
+    }
+    const bool ok =
+        write(file.get(), &header, sizeof(header)) &&
+        write(file.get(), entries.data(), entries.size() * sizeof(Entry)) &&
+        write(file.get(), offsets_.data(), offsets_.size_bytes()) &&
+        write(file.get(), ids_.data(), ids_.size_bytes()) &&
+        write(file.get(), padding,
+              padded(ids_.size_bytes()) - ids_.size_bytes());
+    if (!ok || std::fclose(file.release()) != 0) {
+      std::filesystem::remove(temporary);
+      throw std::runtime_error{"Cannot write snapshot " + snapshot.string()};
+    }
+    std::filesystem::rename(temporary, snapshot);
+  }
+
+ private:
+  struct Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t number_of_actions;
+    std::uint64_t number_of_ids;
+    std::uint64_t number_of_strategies;
+  };
+  struct Entry {
+    std::uint32_t type;
+    std::uint32_t strategy;
+  };
+  static_assert(sizeof(Header) == 40 && sizeof(Entry) == 8);
+  static_assert(sizeof(int) == sizeof(std::int32_t));
+
+  static constexpr char snapshot_magic[8] = {'S', 'N', 'A', 'P',
+                                             'S', 'H', 'O', 'T'};
+  static constexpr std::uint32_t snapshot_version = 1;
+  static constexpr std::uint32_t snapshot_byte_order = 0x01020304;
+  static constexpr std::byte padding[8]{};
+
+  static constexpr std::size_t padded(std::size_t size) {
+    return (size + 7) / 8 * 8;
+  }
+
+  static bool write(std::FILE* file, const void* data, std::size_t size) {
+    return size == 0 || std::fwrite(data, size, 1, file) == 1;
+  }
+
+  Header make_header(std::size_t number_of_actions,
+                     std::size_t number_of_ids) const {
+    Header header{};
+    std::memcpy(header.magic, snapshot_magic, sizeof(snapshot_magic));
+    header.version = snapshot_version;
+    header.byte_order = snapshot_byte_order;
+    header.number_of_actions = number_of_actions;
+    header.number_of_ids = number_of_ids;
+    header.number_of_strategies = strategies_.size();
+    return header;
+  }
+
+  void restore() {
+    const auto bytes = mapping_.bytes();
+    Header header{};
+    if (bytes.size() < sizeof(header)) {
+      throw std::runtime_error{"Not a snapshot (file too short)"};
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, snapshot_magic, sizeof(snapshot_magic)) !=
+            0 ||
+        header.version != snapshot_version ||
+        header.byte_order != snapshot_byte_order) {
+      throw std::runtime_error{"Not a snapshot of this version and platform"};
+    }
+    if (header.number_of_strategies != strategies_.size()) {
+      throw std::runtime_error{
+          "Snapshot taken with a different set of strategies"};
+    }
+    const auto n = header.number_of_actions;
+    // Bound the counts by the file size first, so that no size can overflow
+    const auto available = bytes.size() - sizeof(header);
+    if (n > available / (sizeof(Entry) + sizeof(std::uint64_t)) ||
+        header.number_of_ids > available / sizeof(int)) {
+      throw std::runtime_error{"Snapshot of unexpected size"};
+    }
+    const auto entries_size = n * sizeof(Entry);
+    const auto offsets_size = (n + 1) * sizeof(std::uint64_t);
+    const auto ids_size = header.number_of_ids * sizeof(int);
+    if (bytes.size() !=
+        sizeof(header) + entries_size + offsets_size + padded(ids_size)) {
+      throw std::runtime_error{"Snapshot of unexpected size"};
+    }
+    // All sections are 8-byte aligned in the page-aligned mapping
+    const auto* entries =
+        reinterpret_cast<const Entry*>(bytes.data() + sizeof(header));
+    offsets_ = {reinterpret_cast<const std::uint64_t*>(
+                    bytes.data() + sizeof(header) + entries_size),
+                n + 1};
+    ids_ = {reinterpret_cast<const int*>(bytes.data() + sizeof(header) +
+                                         entries_size + offsets_size),
+            header.number_of_ids};
+    if (offsets_.front() != 0 || offsets_.back() != ids_.size()) {
+      throw std::runtime_error{"Snapshot with inconsistent offsets"};
+    }
+    actions_.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      // particles(i) relies on it not to read out of the ids
+      if (offsets_[i + 1] < offsets_[i] || offsets_[i + 1] > ids_.size()) {
+        throw std::runtime_error{"Snapshot with inconsistent offsets"};
+      }
+      const auto& strategy = strategies_.at(entries[i].strategy);
+      switch (static_cast<ActionType>(entries[i].type)) {
+        case ActionType::scatter:
+          actions_.push_back(
+              std::make_unique<ScatterAction>(*this, i, strategy));
+          break;
+        case ActionType::fluidization:
+          actions_.push_back(
+              std::make_unique<FluidizationAction>(*this, i, strategy));
+          break;
+        default:
+          throw std::runtime_error{"Unknown action type in snapshot"};
+      }
+    }
+  }
+
+  // Copy mapped offsets and ids into owned buffers, before changing them
+  void make_owned() {
+    if (is_mapped()) {
+      std::vector<std::uint64_t> offsets(offsets_.begin(), offsets_.end());
+      std::vector<int> ids(ids_.begin(), ids_.end());
+      owned_offsets_ = std::move(offsets);
+      owned_ids_ = std::move(ids);
+      offsets_ = owned_offsets_;
+      ids_ = owned_ids_;
+      mapping_ = FileMapping{};
+    }
+  }
+
+  // Grow geometrically, so that the next n elements can be added without
+  // any allocation
+  template <typename V>
+  static void make_room(V& v, std::size_t n) {
+    if (v.size() + n > v.capacity()) {
+      v.reserve(std::max(v.size() + n, 2 * v.capacity()));
+    }
+  }
+
+  const StrategyRegistry& strategies_;
+  FileMapping mapping_{};
+  std::vector<std::uint64_t> owned_offsets_{0};
+  std::vector<int> owned_ids_{};
+  std::span<const std::uint64_t> offsets_{owned_offsets_};
+  std::span<const int> ids_{};
+  Actions actions_{};
+};
+
+inline std::span<const int> Action::particles() const {
+  return state_.particles(index_);
+}
+
+class PerformStandardStrategy : public PerformStrategy {
+ public:
+  void perform(ScatterAction const& action) const override {
+    if (const auto& p = action.particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+  void perform(FluidizationAction const& action) const override {
+    if (const auto& p = action.particles(); p.size() > 0) {
+      std::cout << "Particle " << p.back() << " will be melt.\n";
+    }
+  }
+};
+
+// A strategy with a state, which still can be shared among many actions
+class PerformColoredStrategy : public PerformStrategy {
+ public:
+  explicit PerformColoredStrategy(std::string color)
+      : color_{std::move(color)} {}
+  void perform(ScatterAction const& action) const override {
+    if (const auto& p = action.particles(); p.size() > 1) {
+      std::cout << color_ << "Scattering between " << p[0] << " and " << p[1]
+                << ".\e[0m\n";
+    }
+  }
+  void perform(FluidizationAction const& action) const override {
+    if (const auto& p = action.particles(); p.size() > 0) {
+      std::cout << color_ << "Particle " << p.back() << " will be melt.\e[0m\n";
+    }
+  }
+
+ private:
+  std::string color_;
+};
+
+void perform_all_actions(const Actions& actions) {
+  for (const auto& action : actions) {
+    action->perform();
+  }
+}
+
+int main() {
+  const auto snapshot =
+      std::filesystem::temp_directory_path() / "actions.snapshot";
+  {
+    // The registry is declared first, so that it outlives the actions
+    StrategyRegistry strategies{};
+    const auto& red = strategies.add<PerformColoredStrategy>("\e[91m");
+    const auto& standard = strategies.shared<PerformStandardStrategy>();
+
+    // Creating actions
+    ActionState state{strategies};
+    state.emplace<ScatterAction>({1, 11, 111}, standard);
+    state.emplace<FluidizationAction>({2, 22, 222}, standard);
+    state.emplace<ScatterAction>({3, 33, 333}, red);
+
+    std::cout << "PERFORM before saving:\n";
+    perform_all_actions(state.actions());
+    state.save(snapshot);
+  }
+  {
+    // After a restart, strategies are registered in the same order
+    StrategyRegistry strategies{};
+    strategies.add<PerformColoredStrategy>("\e[91m");
+    const auto& standard = strategies.shared<PerformStandardStrategy>();
+
+    ActionState state{strategies, snapshot};
+    std::cout << "PERFORM after restoring " << state.actions().size()
+              << " actions (mapped: " << std::boolalpha << state.is_mapped()
+              << "):\n";
+    perform_all_actions(state.actions());
+
+    // Particles of a restored action can be reused, also while mapped
+    state.emplace<FluidizationAction>(state.actions()[0]->particles(),
+                                      standard);
+    state.emplace<FluidizationAction>({4, 44, 444}, standard);
+    std::cout << "PERFORM after adding two more actions (mapped: "
+              << state.is_mapped() << "):\n";
+    perform_all_actions(state.actions());
+  }
+  {
+    // A restored state can be saved over the file it was restored from
+    StrategyRegistry strategies{};
+    strategies.add<PerformColoredStrategy>("\e[91m");
+    strategies.shared<PerformStandardStrategy>();
+    ActionState state{strategies, snapshot};
+    state.save(snapshot);
+    std::cout << ActionState{strategies, snapshot}.actions().size()
+              << " actions saved again over the same snapshot.\n";
+  }
+  std::filesystem::remove(snapshot);
+}
@@ -0,0 +1,876 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+/*
+ * Benchmark of the different ways of running an operation over actions
+ * discussed in the meetings of May and October 2025:
+ *
+ *  1) virtual perform()                  ↳ 06_start.cpp, 09_start.cpp
+ *  2) classic visitor                    ↳ 06_classic_visitor.cpp
+ *  3) acyclic visitor                    ↳ 06_classic_acyclic_visitor.cpp
+ *  4) std::variant + std::visit          ↳ 06_*_variant.cpp
+ *  5) strategy via std::unique_ptr       ↳ 09_classic_strategy.cpp
+ *     strategy via std::function         ↳ 09_classic_strategy_function.cpp
+ *
+ * Each design is a faithful copy of the meeting code (particles access
+ * included), with the std::cout output replaced by an operation that either
+ * does nothing or accumulates the particle ids it reads into a checksum.
+ * All designs run over the very same random sequence of actions.
+ *
+ * Usage:
+ *   ./a.out [--sizes=1000,10000,...] [--mix=S:F:D] [--operation=noop|count]
+ *           [--seed=N]
+ *
+ *   --sizes      number of actions, default 10^3 up to 10^6 (10^7 is fine,
+ *                but it needs a few GB of memory for some of the designs)
+ *   --mix        relative weights of scatter, fluidization and decay actions
+ *   --operation  what each action does with its particles
+ *
+ * Reported are the time per action, the throughput and the number of heap
+ * allocations done while building the actions and during a dispatch pass (the
+ * largest number over all passes). Running an operation over actions must
+ * never allocate: if any dispatch pass does, the benchmark reports it and
+ * exits with a non-zero status, so that it can be used as a regression test,
+ * too. Note that this checks the copies of the designs in this file only, a
+ * change in the meeting files themselves is not noticed.
+ */
+
+//============================ INFRASTRUCTURE =================================
+
+namespace {
+std::size_t allocation_count = 0;
+}
+
+// All replaceable allocation functions are counted, the array and nothrow
+// ones which are not replaced here call the replaced ones by default
+void* counted_allocation(std::size_t size, std::size_t alignment) noexcept {
+  ++allocation_count;
+  size = size == 0 ? 1 : size;
+  if (alignment <= alignof(std::max_align_t)) {
+    return std::malloc(size);
+  }
+  return std::aligned_alloc(alignment,
+                            (size + alignment - 1) / alignment * alignment);
+}
+
+void* operator new(std::size_t size) {
+  if (void* p = counted_allocation(size, 0)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  if (void* p =
+          counted_allocation(size, static_cast<std::size_t>(alignment))) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return counted_allocation(size, 0);
+}
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+  return counted_allocation(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+
+using Particles = std::vector<int>;
+
+enum class Kind { scatter, fluidization, decay };
+
+struct ActionSpec {
+  Kind kind;
+  Particles particles;
+};
+
+// What actions do with their particles instead of printing them
+struct Sink {
+  bool counting = true;
+  std::uint64_t checksum = 0;
+
+  void record(int id) {
+    if (counting) {
+      checksum += static_cast<std::uint64_t>(id);
+    }
+  }
+};
+
+Sink sink{};
+
+void perform_scatter(std::span<const int> p) {
+  if (p.size() > 1) {
+    sink.record(p[0]);
+    sink.record(p[1]);
+  }
+}
+
+void perform_fluidization(std::span<const int> p) {
+  if (p.size() > 0) {
+    sink.record(p[p.size() - 1]);
+  }
+}
+
+void perform_decay(std::span<const int> p) {
+  for (auto id : p) {
+    sink.record(id);
+  }
+}
+
+//============================ DESIGN 1 =======================================
+
+namespace virtual_perform {
+
+class Action {
+ public:
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  virtual ~Action() = default;
+  std::span<const int> particles() const { return particles_; }
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    auto p = particles();
+    perform_scatter(p);
+  }
+};
+
+class FluidizationAction : public Action {
+ public:
+  explicit FluidizationAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    auto p = particles();
+    perform_fluidization(p);
+  }
+};
+
+class DecayAction : public Action {
+ public:
+  explicit DecayAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override { perform_decay(particles()); }
+};
+
+struct Design {
+  static constexpr std::string_view name = "virtual perform()";
+  using Actions = std::vector<std::unique_ptr<Action>>;
+
+  static Actions build(const std::vector<ActionSpec>& specs) {
+    Actions actions{};
+    actions.reserve(specs.size());
+    for (const auto& spec : specs) {
+      Particles p = spec.particles;
+      switch (spec.kind) {
+        case Kind::scatter:
+          actions.emplace_back(std::make_unique<ScatterAction>(std::move(p)));
+          break;
+        case Kind::fluidization:
+          actions.emplace_back(
+              std::make_unique<FluidizationAction>(std::move(p)));
+          break;
+        case Kind::decay:
+          actions.emplace_back(std::make_unique<DecayAction>(std::move(p)));
+          break;
+      }
+    }
+    return actions;
+  }
+
+  static void run(const Actions& actions) {
+    for (const auto& action : actions) {
+      action->perform();
+    }
+  }
+};
+
+}  // namespace virtual_perform
+
+//============================ DESIGN 2 =======================================
+
+namespace classic_visitor {
+
+class ScatterAction;
+class FluidizationAction;
+class DecayAction;
+
+class ActionVisitor {
+ public:
+  virtual void visit(const ScatterAction&) const = 0;
+  virtual void visit(const FluidizationAction&) const = 0;
+  virtual void visit(const DecayAction&) const = 0;
+};
+
+class Action {
+ public:
+  Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  virtual ~Action() = default;
+  std::span<const int> particles() const { return particles_; }
+  virtual void accept(const ActionVisitor&) = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  ScatterAction(Particles p) : Action{std::move(p)} {}
+  void accept(const ActionVisitor& visitor) override { visitor.visit(*this); }
+};
+
+class FluidizationAction : public Action {
+ public:
+  FluidizationAction(Particles p) : Action{std::move(p)} {}
+  void accept(const ActionVisitor& visitor) override { visitor.visit(*this); }
+};
+
+class DecayAction : public Action {
+ public:
+  DecayAction(Particles p) : Action{std::move(p)} {}
+  void accept(const ActionVisitor& visitor) override { visitor.visit(*this); }
+};
+
+class Performer : public ActionVisitor {
+ public:
+  void visit(const ScatterAction& action) const override {
+    auto particles = action.particles();
+    perform_scatter(particles);
+  }
+  void visit(const FluidizationAction& action) const override {
+    auto particles = action.particles();
+    perform_fluidization(particles);
+  }
+  void visit(const DecayAction& action) const override {
+    perform_decay(action.particles());
+  }
+};
+
+struct Design {
+  static constexpr std::string_view name = "classic visitor";
+  using Actions = std::vector<std::unique_ptr<Action>>;
+
+  static Actions build(const std::vector<ActionSpec>& specs) {
+    Actions actions{};
+    actions.reserve(specs.size());
+    for (const auto& spec : specs) {
+      Particles p = spec.particles;
+      switch (spec.kind) {
+        case Kind::scatter:
+          actions.emplace_back(std::make_unique<ScatterAction>(std::move(p)));
+          break;
+        case Kind::fluidization:
+          actions.emplace_back(
+              std::make_unique<FluidizationAction>(std::move(p)));
+          break;
+        case Kind::decay:
+          actions.emplace_back(std::make_unique<DecayAction>(std::move(p)));
+          break;
+      }
+    }
+    return actions;
+  }
+
+  static void run(const Actions& actions) {
+    for (const auto& action : actions) {
+      action->accept(Performer{});
+    }
+  }
+};
+
+}  // namespace classic_visitor
+
+//============================ DESIGN 3 =======================================
+
+namespace acyclic_visitor {
+
+class AbstractActionVisitor {
+ public:
+  virtual ~AbstractActionVisitor() = default;
+};
+
+template <typename T>
+class ActionVisitor {
+ public:
+  virtual ~ActionVisitor() = default;
+  virtual void visit(const T&) const = 0;
+};
+
+class Action {
+ public:
+  Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  virtual ~Action() = default;
+  std::span<const int> particles() const { return particles_; }
+  virtual void accept(const AbstractActionVisitor&) const = 0;
+
+ private:
+  Particles particles_;
+};
+
+template <typename T>
+void accept_as(const T& action, const AbstractActionVisitor& visitor) {
+  if (auto concrete_visitor =
+          dynamic_cast<const ActionVisitor<T>*>(&visitor)) {
+    concrete_visitor->visit(action);
+  }
+}
+
+class ScatterAction : public Action {
+ public:
+  ScatterAction(Particles p) : Action{std::move(p)} {}
+  void accept(const AbstractActionVisitor& visitor) const override {
+    accept_as(*this, visitor);
+  }
+};
+
+class FluidizationAction : public Action {
+ public:
+  FluidizationAction(Particles p) : Action{std::move(p)} {}
+  void accept(const AbstractActionVisitor& visitor) const override {
+    accept_as(*this, visitor);
+  }
+};
+
+class DecayAction : public Action {
+ public:
+  DecayAction(Particles p) : Action{std::move(p)} {}
+  void accept(const AbstractActionVisitor& visitor) const override {
+    accept_as(*this, visitor);
+  }
+};
+
+class Performer : public AbstractActionVisitor,
+                  public ActionVisitor<ScatterAction>,
+                  public ActionVisitor<FluidizationAction>,
+                  public ActionVisitor<DecayAction> {
+ public:
+  void visit(const ScatterAction& action) const override {
+    auto particles = action.particles();
+    perform_scatter(particles);
+  }
+  void visit(const FluidizationAction& action) const override {
+    auto particles = action.particles();
+    perform_fluidization(particles);
+  }
+  void visit(const DecayAction& action) const override {
+    perform_decay(action.particles());
+  }
+};
+
+struct Design {
+  static constexpr std::string_view name = "acyclic visitor";
+  using Actions = std::vector<std::unique_ptr<Action>>;
+
+  static Actions build(const std::vector<ActionSpec>& specs) {
+    Actions actions{};
+    actions.reserve(specs.size());
+    for (const auto& spec : specs) {
+      Particles p = spec.particles;
+      switch (spec.kind) {
+        case Kind::scatter:
+          actions.emplace_back(std::make_unique<ScatterAction>(std::move(p)));
+          break;
+        case Kind::fluidization:
+          actions.emplace_back(
+              std::make_unique<FluidizationAction>(std::move(p)));
+          break;
+        case Kind::decay:
+          actions.emplace_back(std::make_unique<DecayAction>(std::move(p)));
+          break;
+      }
+    }
+    return actions;
+  }
+
+  static void run(const Actions& actions) {
+    for (const auto& action : actions) {
+      action->accept(Performer{});
+    }
+  }
+};
+
+}  // namespace acyclic_visitor
+
+//============================ DESIGN 4 =======================================
+
+namespace variant_visit {
+
+class ScatterAction {
+ public:
+  ScatterAction(Particles p) : particles_{std::move(p)} {}
+  std::span<const int> particles() const { return particles_; }
+
+ private:
+  Particles particles_;
+};
+
+class FluidizationAction {
+ public:
+  FluidizationAction(Particles p) : particles_{std::move(p)} {}
+  std::span<const int> particles() const { return particles_; }
+
+ private:
+  Particles particles_;
+};
+
+class DecayAction {
+ public:
+  DecayAction(Particles p) : particles_{std::move(p)} {}
+  std::span<const int> particles() const { return particles_; }
+
+ private:
+  Particles particles_;
+};
+
+using Action = std::variant<ScatterAction, FluidizationAction, DecayAction>;
+
+class Performer {
+ public:
+  void operator()(const ScatterAction& action) const {
+    auto particles = action.particles();
+    perform_scatter(particles);
+  }
+  void operator()(const FluidizationAction& action) const {
+    auto particles = action.particles();
+    perform_fluidization(particles);
+  }
+  void operator()(const DecayAction& action) const {
+    perform_decay(action.particles());
+  }
+};
+
+struct Design {
+  static constexpr std::string_view name = "std::variant + std::visit";
+  using Actions = std::vector<Action>;
+
+  static Actions build(const std::vector<ActionSpec>& specs) {
+    Actions actions{};
+    actions.reserve(specs.size());
+    for (const auto& spec : specs) {
+      Particles p = spec.particles;
+      switch (spec.kind) {
+        case Kind::scatter:
+          actions.emplace_back(ScatterAction{std::move(p)});
+          break;
+        case Kind::fluidization:
+          actions.emplace_back(FluidizationAction{std::move(p)});
+          break;
+        case Kind::decay:
+          actions.emplace_back(DecayAction{std::move(p)});
+          break;
+      }
+    }
+    return actions;
+  }
+
+  static void run(const Actions& actions) {
+    for (auto& action : actions) {
+      std::visit(Performer{}, action);
+    }
+  }
+};
+
+}  // namespace variant_visit
+
+//============================ DESIGN 5a ======================================
+
+namespace strategy_unique_ptr {
+
+class ScatterAction;
+class FluidizationAction;
+class DecayAction;
+
+class PerformStrategy {
+ public:
+  virtual ~PerformStrategy() {}
+  virtual void perform(const ScatterAction&) const = 0;
+  virtual void perform(const FluidizationAction&) const = 0;
+  virtual void perform(const DecayAction&) const = 0;
+};
+
+class Action {
+ public:
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  virtual ~Action() = default;
+  std::span<const int> particles() const { return particles_; }
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+template <typename Derived>
+class StrategyAction : public Action {
+ public:
+  StrategyAction(Particles p, std::unique_ptr<PerformStrategy>&& ps)
+      : Action{std::move(p)}, performer_{std::move(ps)} {}
+  void perform() const override {
+    performer_->perform(static_cast<const Derived&>(*this));
+  }
+
+ private:
+  std::unique_ptr<PerformStrategy> performer_ = nullptr;
+};
+
+class ScatterAction : public StrategyAction<ScatterAction> {
+  using StrategyAction::StrategyAction;
+};
+class FluidizationAction : public StrategyAction<FluidizationAction> {
+  using StrategyAction::StrategyAction;
+};
+class DecayAction : public StrategyAction<DecayAction> {
+  using StrategyAction::StrategyAction;
+};
+
+class PerformStandardStrategy : public PerformStrategy {
+ public:
+  void perform(ScatterAction const& action) const override {
+    auto p = action.particles();
+    perform_scatter(p);
+  }
+  void perform(FluidizationAction const& action) const override {
+    auto p = action.particles();
+    perform_fluidization(p);
+  }
+  void perform(DecayAction const& action) const override {
+    perform_decay(action.particles());
+  }
+};
+
+struct Design {
+  static constexpr std::string_view name = "strategy (std::unique_ptr)";
+  using Actions = std::vector<std::unique_ptr<Action>>;
+
+  static Actions build(const std::vector<ActionSpec>& specs) {
+    Actions actions{};
+    actions.reserve(specs.size());
+    for (const auto& spec : specs) {
+      Particles p = spec.particles;
+      switch (spec.kind) {
+        case Kind::scatter:
+          actions.emplace_back(std::make_unique<ScatterAction>(
+              std::move(p), std::make_unique<PerformStandardStrategy>()));
+          break;
+        case Kind::fluidization:
+          actions.emplace_back(std::make_unique<FluidizationAction>(
+              std::move(p), std::make_unique<PerformStandardStrategy>()));
+          break;
+        case Kind::decay:
+          actions.emplace_back(std::make_unique<DecayAction>(
+              std::move(p), std::make_unique<PerformStandardStrategy>()));
+          break;
+      }
+    }
+    return actions;
+  }
+
+  static void run(const Actions& actions) {
+    for (const auto& action : actions) {
+      action->perform();
+    }
+  }
+};
+
+}  // namespace strategy_unique_ptr
+
+//============================ DESIGN 5b ======================================
+
+namespace strategy_function {
+
+class Action {
+ public:
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  virtual ~Action() = default;
+  std::span<const int> particles() const { return particles_; }
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+template <typename Derived>
+class StrategyAction : public Action {
+ public:
+  using PerformStrategy = std::function<void(Derived const&)>;
+  StrategyAction(Particles p, PerformStrategy ps)
+      : Action{std::move(p)}, performer_{std::move(ps)} {}
+  void perform() const override {
+    performer_(static_cast<const Derived&>(*this));
+  }
+
+ private:
+  PerformStrategy performer_{};
+};
+
+class ScatterAction : public StrategyAction<ScatterAction> {
+  using StrategyAction::StrategyAction;
+};
+class FluidizationAction : public StrategyAction<FluidizationAction> {
+  using StrategyAction::StrategyAction;
+};
+class DecayAction : public StrategyAction<DecayAction> {
+  using StrategyAction::StrategyAction;
+};
+
+class PerformStandardStrategy {
+ public:
+  void operator()(ScatterAction const& action) const {
+    auto p = action.particles();
+    perform_scatter(p);
+  }
+  void operator()(FluidizationAction const& action) const {
+    auto p = action.particles();
+    perform_fluidization(p);
+  }
+  void operator()(DecayAction const& action) const {
+    perform_decay(action.particles());
+  }
+};
+
+struct Design {
+  static constexpr std::string_view name = "strategy (std::function)";
+  using Actions = std::vector<std::unique_ptr<Action>>;
+
+  static Actions build(const std::vector<ActionSpec>& specs) {
+    Actions actions{};
+    actions.reserve(specs.size());
+    for (const auto& spec : specs) {
+      Particles p = spec.particles;
+      switch (spec.kind) {
+        case Kind::scatter:
+          actions.emplace_back(std::make_unique<ScatterAction>(
+              std::move(p), PerformStandardStrategy{}));
+          break;
+        case Kind::fluidization:
+          actions.emplace_back(std::make_unique<FluidizationAction>(
+              std::move(p), PerformStandardStrategy{}));
+          break;
+        case Kind::decay:
+          actions.emplace_back(std::make_unique<DecayAction>(
+              std::move(p), PerformStandardStrategy{}));
+          break;
+      }
+    }
+    return actions;
+  }
+
+  static void run(const Actions& actions) {
+    for (const auto& action : actions) {
+      action->perform();
+    }
+  }
+};
+
+}  // namespace strategy_function
+
+//============================ DRIVER =========================================
+
+struct Options {
+  std::vector<std::size_t> sizes{1'000, 10'000, 100'000, 1'000'000};
+  double weights[3] = {1.0, 1.0, 1.0};
+  bool counting = true;
+  unsigned seed = 42;
+};
+
+std::vector<ActionSpec> make_specs(std::size_t n, const Options& options) {
+  std::mt19937 generator{options.seed};
+  std::discrete_distribution<int> random_kind{std::begin(options.weights),
+                                              std::end(options.weights)};
+  std::uniform_int_distribution<int> random_id{0, 1'000'000};
+  std::uniform_int_distribution<int> random_size{1, 3};
+  std::vector<ActionSpec> specs{};
+  specs.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto kind = static_cast<Kind>(random_kind(generator));
+    Particles p(kind == Kind::scatter ? 2 : random_size(generator));
+    std::generate(p.begin(), p.end(), [&] { return random_id(generator); });
+    specs.push_back({kind, std::move(p)});
+  }
+  return specs;
+}
+
+// Returns the largest number of heap allocations done during a dispatch pass
+template <typename Design>
+std::size_t benchmark(const std::vector<ActionSpec>& specs) {
+  using clock = std::chrono::steady_clock;
+  const auto allocations_before_build = allocation_count;
+  const auto actions = Design::build(specs);
+  const auto allocations_in_build = allocation_count - allocations_before_build;
+
+  // Repeat passes to run at least ~10^7 actions per measurement, keep the best
+  const std::size_t n = specs.size();
+  const std::size_t passes = std::max<std::size_t>(3, 10'000'000 / n);
+  double best_ns = std::numeric_limits<double>::max();
+  std::size_t allocations_per_pass = 0;
+  sink.checksum = 0;
+  for (std::size_t pass = 0; pass < passes; ++pass) {
+    const auto allocations_before_pass = allocation_count;
+    const auto start = clock::now();
+    Design::run(actions);
+    const auto stop = clock::now();
+    allocations_per_pass = std::max(allocations_per_pass,
+                                    allocation_count - allocations_before_pass);
+    best_ns = std::min(
+        best_ns,
+        std::chrono::duration<double, std::nano>(stop - start).count());
+  }
+  const double ns_per_action = best_ns / static_cast<double>(n);
+  std::cout << std::left << std::setw(30) << Design::name << std::right
+            << std::setw(10) << n << std::fixed << std::setprecision(2)
+            << std::setw(12) << ns_per_action << std::setw(14)
+            << 1e3 / ns_per_action << std::setw(14) << allocations_in_build
+            << std::setw(14) << allocations_per_pass << std::setw(22)
+            << sink.checksum / passes << "\n";
+  return allocations_per_pass;
+}
+
+std::vector<std::string_view> split(std::string_view s, char separator) {
+  std::vector<std::string_view> tokens{};
+  while (true) {
+    const auto position = s.find(separator);
+    tokens.push_back(s.substr(0, position));
+    if (position == std::string_view::npos) {
+      return tokens;
+    }
+    s.remove_prefix(position + 1);
+  }
+}
+
+Options parse_options(int argc, char* argv[]) {
+  Options options{};
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view argument{argv[i]};
+    auto value_of = [&](std::string_view key) {
+      return argument.substr(key.size());
+    };
+    if (argument.starts_with("--sizes=")) {
+      options.sizes.clear();
+      for (auto token : split(value_of("--sizes="), ',')) {
+        options.sizes.push_back(std::stoull(std::string{token}));
+      }
+    } else if (argument.starts_with("--mix=")) {
+      const auto tokens = split(value_of("--mix="), ':');
+      if (tokens.size() != 3) {
+        throw std::invalid_argument{"--mix expects three weights, S:F:D"};
+      }
+      for (std::size_t k = 0; k < 3; ++k) {
+        options.weights[k] = std::stod(std::string{tokens[k]});
+      }
+    } else if (argument.starts_with("--operation=")) {
+      const auto operation = value_of("--operation=");
+      if (operation != "noop" && operation != "count") {
+        throw std::invalid_argument{"--operation must be noop or count"};
+      }
+      options.counting = (operation == "count");
+    } else if (argument.starts_with("--seed=")) {
+      options.seed = std::stoul(std::string{value_of("--seed=")});
+    } else {
+      throw std::invalid_argument{"Unknown option " + std::string{argument}};
+    }
+  }
+  return options;
+}
+
+int main(int argc, char* argv[]) {
+  Options options{};
+  try {
+    options = parse_options(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  sink.counting = options.counting;
+
+  std::cout << "Mix S:F:D = " << options.weights[0] << ":" << options.weights[1]
+            << ":" << options.weights[2] << ", operation = "
+            << (options.counting ? "count" : "noop") << "\n\n"
+            << std::left << std::setw(30) << "design" << std::right
+            << std::setw(10) << "actions" << std::setw(12) << "ns/action"
+            << std::setw(14) << "Mactions/s" << std::setw(14) << "allocs/build"
+            << std::setw(14) << "allocs/pass" << std::setw(22) << "checksum"
+            << "\n";
+  std::vector<std::string_view> allocating_designs{};
+  auto check = [&allocating_designs](std::string_view name,
+                                     std::size_t allocations) {
+    if (allocations > 0 &&
+        std::find(allocating_designs.begin(), allocating_designs.end(),
+                  name) == allocating_designs.end()) {
+      allocating_designs.push_back(name);
+    }
+  };
+  for (auto n : options.sizes) {
+    const auto specs = make_specs(n, options);
+    check(virtual_perform::Design::name,
+          benchmark<virtual_perform::Design>(specs));
+    check(classic_visitor::Design::name,
+          benchmark<classic_visitor::Design>(specs));
+    check(acyclic_visitor::Design::name,
+          benchmark<acyclic_visitor::Design>(specs));
+    check(variant_visit::Design::name, benchmark<variant_visit::Design>(specs));
+    check(strategy_unique_ptr::Design::name,
+          benchmark<strategy_unique_ptr::Design>(specs));
+    check(strategy_function::Design::name,
+          benchmark<strategy_function::Design>(specs));
+    std::cout << "\n";
+  }
+
+  for (auto name : allocating_designs) {
+    std::cerr << "FAILURE: " << name << " allocates while dispatching.\n";
+  }
+  return allocating_designs.empty() ? 0 : 2;
+}
@@ -11,6 +11,7 @@
 
 #include <iostream>
 #include <memory>
+#include <span>
 #include <vector>
 
 class Action;
@@ -30,7 +31,7 @@ class Action {
     virtual ~Action() = default;
 
     // External read-access to particles
-    const Particles& particles() const { return particles_; }
+    std::span<const int> particles() const { return particles_; }
 
     // Operations
     virtual void perform() const = 0;
@@ -0,0 +1,333 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+ * Same actions as in 09_start.cpp, performing through an ActionLog instead
+ * of writing to std::cout.
+ *
+ *  1) Each thread writes into its own buffer
+ *      ↳ no lock and no stream formatter on the hot path;
+ *      ↳ integers are formatted with std::to_chars (locale-independent);
+ *      ↳ a single write(...) call is never split between two blocks.
+ *  2) Full buffers are handed over to a background writer thread
+ *      ↳ the writer issues large write(2) calls on a file descriptor;
+ *      ↳ written blocks are recycled, so in steady state nothing allocates.
+ *  3) Ordering
+ *      ↳ messages of the same thread keep their order;
+ *      ↳ messages of different threads are interleaved block by block.
+ *
+ * The log must be destroyed (or flushed) only when no thread is using it
+ * anymore: its destructor writes all pending messages and stops the writer.
+ * A failed write(2) is reported by the next flush(), on the calling thread,
+ * and later blocks are dropped until then. The destructor cannot report it,
+ * hence call flush() explicitly before if errors matter.
+ */
+
+class ActionLog {
+ public:
+  explicit ActionLog(int fd = STDOUT_FILENO, std::size_t block_size = 1 << 16)
+      : fd_{fd}, block_size_{block_size}, writer_{[this] { writer_loop(); }} {}
+  // Rule of 5: the log owns a running thread and cannot be copied or moved
+  ActionLog(const ActionLog&) = delete;
+  ActionLog& operator=(const ActionLog&) = delete;
+  ActionLog(ActionLog&&) = delete;
+  ActionLog& operator=(ActionLog&&) = delete;
+  ~ActionLog() {
+    try {
+      flush();
+    } catch (...) {
+      // Nothing sensible to do here, see flush()
+    }
+    {
+      std::lock_guard lock{mutex_};
+      stop_ = true;
+    }
+    block_ready_.notify_one();
+    writer_.join();
+  }
+
+  // Append all pieces (strings, characters or integers) as one message
+  template <typename... Pieces>
+  void write(const Pieces&... pieces) {
+    auto& buffer = thread_buffer();
+    const auto size = (max_size(pieces) + ... + 0);
+    if (buffer.size() + size > block_size_) {
+      submit(buffer);
+    }
+    (append(buffer, pieces), ...);
+  }
+
+  // Hand all thread buffers over to the writer and wait until written. Throw
+  // the first write error which occurred since the previous flush, if any.
+  void flush() {
+    {
+      std::lock_guard lock{mutex_};
+      for (auto& buffer : thread_buffers_) {
+        if (!buffer->empty()) {
+          blocks_.push_back(std::move(*buffer));
+          *buffer = take_free_block();
+        }
+      }
+    }
+    block_ready_.notify_one();
+    std::unique_lock lock{mutex_};
+    all_written_.wait(lock, [this] { return blocks_.empty() && !writing_; });
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+ private:
+  using Block = std::vector<char>;
+
+  // Upper bounds of the formatted size of the different pieces
+  static std::size_t max_size(std::string_view s) { return s.size(); }
+  static std::size_t max_size(const char* s) {
+    return std::string_view{s}.size();
+  }
+  static std::size_t max_size(char) { return 1; }
+  template <typename T>
+    requires std::is_integral_v<T>
+  static std::size_t max_size(T) {
+    return std::numeric_limits<T>::digits10 + 2;
+  }
+
+  static void append(Block& buffer, std::string_view s) {
+    buffer.insert(buffer.end(), s.begin(), s.end());
+  }
+  static void append(Block& buffer, const char* s) {
+    append(buffer, std::string_view{s});
+  }
+  static void append(Block& buffer, char c) { buffer.push_back(c); }
+  template <typename T>
+    requires std::is_integral_v<T>
+  static void append(Block& buffer, T value) {
+    const auto old_size = buffer.size();
+    buffer.resize(old_size + max_size(value));
+    auto [end, error] = std::to_chars(buffer.data() + old_size,
+                                      buffer.data() + buffer.size(), value);
+    buffer.resize(end - buffer.data());
+  }
+
+  Block& thread_buffer() {
+    // Cached per thread and per log, the id (not the address) identifies the
+    // log instance. A thread has one entry per log it ever wrote to, entries
+    // of destroyed logs are never matched again.
+    struct Entry {
+      std::uint64_t log_id;
+      Block* buffer;
+    };
+    thread_local std::vector<Entry> cache{};
+    for (const auto& entry : cache) {
+      if (entry.log_id == id_) {
+        return *entry.buffer;
+      }
+    }
+    std::lock_guard lock{mutex_};
+    thread_buffers_.push_back(std::make_unique<Block>(take_free_block()));
+    cache.push_back({id_, thread_buffers_.back().get()});
+    return *cache.back().buffer;
+  }
+
+  // Must be called with mutex_ locked
+  Block take_free_block() {
+    Block block{};
+    if (!free_blocks_.empty()) {
+      block = std::move(free_blocks_.back());
+      free_blocks_.pop_back();
+    }
+    block.clear();
+    block.reserve(block_size_);
+    return block;
+  }
+
+  void submit(Block& buffer) {
+    {
+      std::lock_guard lock{mutex_};
+      blocks_.push_back(std::move(buffer));
+      buffer = take_free_block();
+    }
+    block_ready_.notify_one();
+  }
+
+  void write_all(const Block& block) const {
+    const char* data = block.data();
+    std::size_t remaining = block.size();
+    while (remaining > 0) {
+      const auto written = ::write(fd_, data, remaining);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw std::system_error{errno, std::generic_category(),
+                                "ActionLog failed to write"};
+      }
+      data += written;
+      remaining -= static_cast<std::size_t>(written);
+    }
+  }
+
+  void writer_loop() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      block_ready_.wait(lock, [this] { return stop_ || !blocks_.empty(); });
+      if (blocks_.empty()) {
+        return;  // stop requested and nothing left to write
+      }
+      Block block = std::move(blocks_.front());
+      blocks_.pop_front();
+      writing_ = true;
+      const bool failed = static_cast<bool>(error_);
+      lock.unlock();
+      std::exception_ptr error{};
+      if (!failed) {
+        // An exception escaping this thread would terminate the program
+        try {
+          write_all(block);
+        } catch (const std::system_error&) {
+          error = std::current_exception();
+        }
+      }
+      lock.lock();
+      writing_ = false;
+      if (error) {
+        error_ = error;
+      }
+      free_blocks_.push_back(std::move(block));
+      if (blocks_.empty()) {
+        all_written_.notify_all();
+      }
+    }
+  }
+
+  inline static std::atomic<std::uint64_t> next_id_{1};
+
+  const std::uint64_t id_ = next_id_++;
+  const int fd_;
+  const std::size_t block_size_;
+  std::mutex mutex_{};
+  std::condition_variable block_ready_{};
+  std::condition_variable all_written_{};
+  std::vector<std::unique_ptr<Block>> thread_buffers_{};
+  std::deque<Block> blocks_{};
+  std::vector<Block> free_blocks_{};
+  std::exception_ptr error_{};
+  bool writing_ = false;
+  bool stop_ = false;
+  std::thread writer_;  // last, to start after all other members
+};
+
+class Action;
+
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform(ActionLog&) const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p) : Action{std::move(p)} {}
+  void perform(ActionLog& log) const override {
+    if (const auto& p = particles(); p.size() > 1) {
+      log.write("Scattering between ", p[0], " and ", p[1], ".\n");
+    }
+  }
+};
+
+class FluidizationAction : public Action {
+ public:
+  explicit FluidizationAction(Particles p) : Action{std::move(p)} {}
+  void perform(ActionLog& log) const override {
+    if (const auto& p = particles(); p.size() > 0) {
+      log.write("Particle ", p.back(), " will be melt.\n");
+    }
+  }
+};
+
+void perform_all_actions(const Actions& actions, ActionLog& log) {
+  for (const auto& action : actions) {
+    action->perform(log);
+  }
+}
+
+int main() {
+  // Creating actions
+  Particles p1 = {1, 11, 111}, p2 = {2, 22, 222};
+  Actions actions{};
+  actions.emplace_back(std::make_unique<ScatterAction>(std::move(p1)));
+  actions.emplace_back(std::make_unique<FluidizationAction>(std::move(p2)));
+
+  // Performing actions, logging to the standard output
+  ActionLog log{STDOUT_FILENO};
+  log.write("PERFORM:\n");
+  perform_all_actions(actions, log);
+  log.flush();
+
+  // Each thread has its own buffer, the log can be shared
+  log.write("PERFORM on 4 threads:\n");
+  log.flush();
+  {
+    std::vector<std::jthread> threads{};
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back([&] { perform_all_actions(actions, log); });
+    }
+  }
+  log.flush();
+
+  // Write errors are reported on the thread calling flush()
+  ActionLog broken{-1};
+  perform_all_actions(actions, broken);
+  try {
+    broken.flush();
+  } catch (const std::system_error& error) {
+    log.write("Flushing a broken log: ", error.what(), "\n");
+  }
+}
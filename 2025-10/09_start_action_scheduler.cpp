@@ -0,0 +1,286 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Same actions as in 09_start.cpp, but each one happens at a given time and
+ * they are executed in time order by an ActionScheduler.
+ *
+ *  1) Pending actions are kept in a 4-ary min-heap
+ *      ↳ heap entries are small (time, stamp, slot), the actions themselves
+ *        stay where they are and are never moved while sifting;
+ *      ↳ with 4 children per node the heap is half as deep as a binary one
+ *        and the children of a node are adjacent in memory (4 entries of 24
+ *        bytes, hence they span two or three cache lines).
+ *  2) Invalidation is lazy
+ *      ↳ the scheduler has a clock, ticking at each schedule and at each
+ *        accepted action, and it stamps every action when scheduled;
+ *      ↳ accepting an action stamps its particles as consumed, stamps are
+ *        kept in a hash map, since particle ids can be sparse and large;
+ *      ↳ an action is invalid if any of its particles was consumed after the
+ *        action was scheduled, which is checked only when it becomes due;
+ *      ↳ nothing is searched nor removed from the heap when a particle is
+ *        consumed, stale actions are simply dropped when popped.
+ *  3) pop_due(t, batch) hands out all valid actions due up to time t
+ *      ↳ in time order, ties in the order in which they were scheduled;
+ *      ↳ the batch is a caller-owned vector, reused from step to step.
+ */
+
+class Action;
+
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  explicit Action(double time, Particles p)
+      : time_{time}, particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to time and particles
+  double time() const { return time_; }
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform() const = 0;
+
+ private:
+  double time_;
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(double time, Particles p)
+      : Action{time, std::move(p)} {}
+  void perform() const override {
+    if (auto p = particles(); p.size() > 1) {
+      std::cout << "t = " << time() << ": Scattering between " << p[0]
+                << " and " << p[1] << ".\n";
+    }
+  }
+};
+
+class FluidizationAction : public Action {
+ public:
+  explicit FluidizationAction(double time, Particles p)
+      : Action{time, std::move(p)} {}
+  void perform() const override {
+    if (auto p = particles(); p.size() > 0) {
+      std::cout << "t = " << time() << ": Particle " << p.back()
+                << " will be melt.\n";
+    }
+  }
+};
+
+class ActionScheduler {
+ public:
+  void schedule(std::unique_ptr<Action> action) {
+    assert(action != nullptr);
+    const double time = action->time();
+    std::uint32_t slot;
+    if (!free_slots_.empty()) {
+      slot = free_slots_.back();
+      free_slots_.pop_back();
+      pending_[slot] = std::move(action);
+    } else {
+      slot = static_cast<std::uint32_t>(pending_.size());
+      pending_.push_back(std::move(action));
+    }
+    heap_.push_back({time, ++clock_, slot});
+    sift_up(heap_.size() - 1);
+  }
+
+  // Mark a particle as consumed from outside, e.g. if it left the system
+  void consume(int particle) { consumed_at_[particle] = ++clock_; }
+
+  // Move all valid actions due up to the given time into the batch. What can
+  // throw happens before an action is popped, which is then not lost.
+  void pop_due(double time, Actions& batch) {
+    batch.clear();
+    while (!heap_.empty() && heap_.front().time <= time) {
+      const Entry top = heap_.front();
+      const bool valid = is_valid(*pending_[top.slot], top.stamp);
+      make_room_for_one_more(free_slots_);
+      if (valid) {
+        make_room_for_one_more(batch);
+        stamp(*pending_[top.slot], ++clock_);
+      }
+      pop_min();
+      free_slots_.push_back(top.slot);
+      if (valid) {
+        batch.push_back(std::move(pending_[top.slot]));
+      } else {
+        pending_[top.slot].reset();
+        ++discarded_;
+      }
+    }
+  }
+
+  // Time of the earliest pending action, which might turn out to be invalid
+  std::optional<double> next_time() const {
+    if (heap_.empty()) {
+      return std::nullopt;
+    }
+    return heap_.front().time;
+  }
+
+  // Pending actions, including the ones not yet known to be invalid
+  std::size_t size() const noexcept { return heap_.size(); }
+  bool empty() const noexcept { return heap_.empty(); }
+  std::size_t discarded() const noexcept { return discarded_; }
+
+ private:
+  static constexpr std::size_t arity = 4;
+
+  struct Entry {
+    double time;
+    std::uint64_t stamp;  // clock when scheduled, also breaks ties in time
+    std::uint32_t slot;
+
+    bool operator<(const Entry& other) const {
+      return time < other.time || (time == other.time && stamp < other.stamp);
+    }
+  };
+
+  bool is_valid(const Action& action, std::uint64_t scheduled_at) const {
+    for (int particle : action.particles()) {
+      if (const auto it = consumed_at_.find(particle);
+          it != consumed_at_.end() && it->second > scheduled_at) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Entries are inserted first (only this can throw), then all stamped, so
+  // that the action is either fully stamped or not at all
+  void stamp(const Action& action, std::uint64_t now) {
+    for (int particle : action.particles()) {
+      consumed_at_.try_emplace(particle, 0);
+    }
+    for (int particle : action.particles()) {
+      consumed_at_.find(particle)->second = now;
+    }
+  }
+
+  template <typename V>
+  static void make_room_for_one_more(V& v) {
+    if (v.size() == v.capacity()) {
+      v.reserve(std::max<std::size_t>(1, 2 * v.capacity()));
+    }
+  }
+
+  Entry pop_min() {
+    const Entry top = heap_.front();
+    heap_.front() = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty()) {
+      sift_down(0);
+    }
+    return top;
+  }
+
+  void sift_up(std::size_t i) {
+    const Entry entry = heap_[i];
+    while (i > 0) {
+      const auto parent = (i - 1) / arity;
+      if (!(entry < heap_[parent])) {
+        break;
+      }
+      heap_[i] = heap_[parent];
+      i = parent;
+    }
+    heap_[i] = entry;
+  }
+
+  void sift_down(std::size_t i) {
+    const Entry entry = heap_[i];
+    const auto size = heap_.size();
+    while (true) {
+      const auto first_child = arity * i + 1;
+      if (first_child >= size) {
+        break;
+      }
+      const auto last_child = std::min(first_child + arity, size);
+      auto smallest = first_child;
+      for (auto child = first_child + 1; child < last_child; ++child) {
+        if (heap_[child] < heap_[smallest]) {
+          smallest = child;
+        }
+      }
+      if (!(heap_[smallest] < entry)) {
+        break;
+      }
+      heap_[i] = heap_[smallest];
+      i = smallest;
+    }
+    heap_[i] = entry;
+  }
+
+  std::vector<Entry> heap_{};
+  Actions pending_{};
+  std::vector<std::uint32_t> free_slots_{};
+  std::unordered_map<int, std::uint64_t> consumed_at_{};
+  std::uint64_t clock_ = 0;
+  std::size_t discarded_ = 0;
+};
+
+void perform_all_actions(const Actions& actions) {
+  for (const auto& action : actions) {
+    action->perform();
+  }
+}
+
+int main() {
+  // Scheduling actions, not in time order
+  ActionScheduler scheduler{};
+  scheduler.schedule(std::make_unique<ScatterAction>(0.7, Particles{1, 2}));
+  scheduler.schedule(std::make_unique<FluidizationAction>(0.3, Particles{3}));
+  scheduler.schedule(std::make_unique<ScatterAction>(0.5, Particles{2, 3}));
+  // Particle ids can be sparse, stamps do not grow with the largest id
+  scheduler.schedule(
+      std::make_unique<ScatterAction>(1.5, Particles{4, 2'000'000'000}));
+  scheduler.schedule(std::make_unique<FluidizationAction>(1.2, Particles{1}));
+
+  // Performing actions step by step, stale ones are dropped on the way
+  Actions batch{};
+  for (double t = 1.0; !scheduler.empty(); t += 1.0) {
+    scheduler.pop_due(t, batch);
+    std::cout << "PERFORM up to t = " << t << ":\n";
+    perform_all_actions(batch);
+    // Performing may create new actions with the outgoing particles
+    for (const auto& action : batch) {
+      if (action->time() < 1.0) {
+        scheduler.schedule(std::make_unique<FluidizationAction>(
+            action->time() + 1.0, Particles{action->particles().back()}));
+      }
+    }
+  }
+  std::cout << scheduler.discarded() << " invalid action(s) discarded.\n";
+}
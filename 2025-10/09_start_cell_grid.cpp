@@ -0,0 +1,266 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <span>
+#include <vector>
+
+/*
+ * Same actions as in 09_start.cpp, with ScatterAction candidates found by a
+ * uniform cell grid instead of checking all pairs of particles.
+ *
+ *  1) The box is divided into cells at least as large as the interaction range
+ *      ↳ two particles closer than the range are in the same or in
+ *        neighbouring cells;
+ *      ↳ with a roughly uniform density, each cell contains O(1) particles,
+ *        hence finding all close pairs is O(N) instead of O(N²).
+ *  2) Particles are binned in linked cell lists
+ *      ↳ each cell stores the first particle in it, each particle the
+ *        previous and the next one in the same cell;
+ *      ↳ moving a particle is O(1), and nothing is done if it stays in its
+ *        cell (which is the common case for small time steps).
+ *  3) Each pair of neighbouring cells is looked at once (half stencil)
+ *      ↳ the cell itself plus 13 out of its 26 neighbours;
+ *      ↳ each candidate pair is then found exactly once.
+ */
+
+class Action;
+
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    if (auto p = particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+};
+
+struct Position {
+  double x, y, z;
+};
+
+inline double distance_squared(const Position& a, const Position& b) {
+  const double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+  return dx * dx + dy * dy + dz * dz;
+}
+
+class CellGrid {
+ public:
+  // Box from the origin to box_length along each axis
+  CellGrid(double box_length, double interaction_range)
+      : range_squared_{interaction_range * interaction_range},
+        cells_per_side_{std::max(
+            1, static_cast<int>(box_length / interaction_range))},
+        inverse_cell_length_{cells_per_side_ / box_length},
+        head_(static_cast<std::size_t>(cells_per_side_) * cells_per_side_ *
+                  cells_per_side_,
+              end_of_list) {}
+
+  // Bin all particles from scratch
+  void rebin(std::span<const Position> positions) {
+    std::fill(head_.begin(), head_.end(), end_of_list);
+    cell_of_.assign(positions.size(), end_of_list);
+    next_.assign(positions.size(), end_of_list);
+    previous_.assign(positions.size(), end_of_list);
+    for (std::size_t i = 0; i < positions.size(); ++i) {
+      link(static_cast<int>(i), cell_index(positions[i]));
+    }
+  }
+
+  // Update the cell of one particle after it moved, O(1)
+  void move(int particle, const Position& new_position) {
+    const auto cell = cell_index(new_position);
+    if (cell != cell_of_[particle]) {
+      unlink(particle);
+      link(particle, cell);
+    }
+  }
+
+  // Call f(i, j) once for each pair of particles closer than the range
+  template <typename F>
+  void for_each_close_pair(std::span<const Position> positions, F&& f) const {
+    assert(positions.size() == cell_of_.size());
+    const int n = cells_per_side_;
+    for (int cx = 0; cx < n; ++cx) {
+      for (int cy = 0; cy < n; ++cy) {
+        for (int cz = 0; cz < n; ++cz) {
+          const int cell = flat_index(cx, cy, cz);
+          for (int i = head_[cell]; i != end_of_list; i = next_[i]) {
+            // Same cell, each pair once
+            for (int j = next_[i]; j != end_of_list; j = next_[j]) {
+              check_pair(positions, i, j, f);
+            }
+            // Forward half of the neighbouring cells
+            for (const auto& [dx, dy, dz] : half_stencil) {
+              const int nx = cx + dx, ny = cy + dy, nz = cz + dz;
+              if (nx < 0 || ny < 0 || nz < 0 || nx >= n || ny >= n ||
+                  nz >= n) {
+                continue;
+              }
+              for (int j = head_[flat_index(nx, ny, nz)]; j != end_of_list;
+                   j = next_[j]) {
+                check_pair(positions, i, j, f);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  int cells_per_side() const noexcept { return cells_per_side_; }
+
+ private:
+  static constexpr int end_of_list = -1;
+
+  // The 13 neighbours "after" a cell, the other 13 see it as their neighbour
+  static constexpr std::array<std::array<int, 3>, 13> half_stencil{{
+      {1, 0, 0},   {-1, 1, 0},  {0, 1, 0},  {1, 1, 0},  {-1, -1, 1},
+      {0, -1, 1},  {1, -1, 1},  {-1, 0, 1}, {0, 0, 1},  {1, 0, 1},
+      {-1, 1, 1},  {0, 1, 1},   {1, 1, 1},
+  }};
+
+  template <typename F>
+  void check_pair(std::span<const Position> positions, int i, int j,
+                  F& f) const {
+    if (distance_squared(positions[i], positions[j]) < range_squared_) {
+      f(i, j);
+    }
+  }
+
+  int flat_index(int cx, int cy, int cz) const noexcept {
+    return (cx * cells_per_side_ + cy) * cells_per_side_ + cz;
+  }
+
+  // Particles outside the box are put in the closest boundary cell
+  int cell_index(const Position& p) const noexcept {
+    auto to_cell = [this](double coordinate) {
+      const int c = static_cast<int>(coordinate * inverse_cell_length_);
+      return std::clamp(c, 0, cells_per_side_ - 1);
+    };
+    return flat_index(to_cell(p.x), to_cell(p.y), to_cell(p.z));
+  }
+
+  void link(int particle, int cell) {
+    cell_of_[particle] = cell;
+    previous_[particle] = end_of_list;
+    next_[particle] = head_[cell];
+    if (head_[cell] != end_of_list) {
+      previous_[head_[cell]] = particle;
+    }
+    head_[cell] = particle;
+  }
+
+  void unlink(int particle) {
+    const int previous = previous_[particle], next = next_[particle];
+    if (previous != end_of_list) {
+      next_[previous] = next;
+    } else {
+      head_[cell_of_[particle]] = next;
+    }
+    if (next != end_of_list) {
+      previous_[next] = previous;
+    }
+  }
+
+  double range_squared_;
+  int cells_per_side_;
+  double inverse_cell_length_;
+  std::vector<int> head_;        // first particle in each cell
+  std::vector<int> cell_of_{};   // per particle
+  std::vector<int> next_{};      // per particle, next in the same cell
+  std::vector<int> previous_{};  // per particle, previous in the same cell
+};
+
+Actions find_scatter_candidates(const CellGrid& grid,
+                                std::span<const Position> positions) {
+  Actions actions{};
+  grid.for_each_close_pair(positions, [&actions](int i, int j) {
+    actions.emplace_back(std::make_unique<ScatterAction>(Particles{i, j}));
+  });
+  return actions;
+}
+
+std::size_t count_close_pairs_brute_force(std::span<const Position> positions,
+                                          double range) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    for (std::size_t j = i + 1; j < positions.size(); ++j) {
+      count += distance_squared(positions[i], positions[j]) < range * range;
+    }
+  }
+  return count;
+}
+
+int main() {
+  constexpr double box_length = 20.0, range = 1.0;
+  std::mt19937 generator{42};
+  std::uniform_real_distribution<double> uniform{0.0, box_length};
+  std::vector<Position> positions(5000);
+  for (auto& p : positions) {
+    p = {uniform(generator), uniform(generator), uniform(generator)};
+  }
+
+  // Binning and finding candidates
+  CellGrid grid{box_length, range};
+  grid.rebin(positions);
+  auto actions = find_scatter_candidates(grid, positions);
+  std::cout << "Grid of " << grid.cells_per_side() << "³ cells: "
+            << actions.size() << " candidate(s), brute force: "
+            << count_close_pairs_brute_force(positions, range) << "\n";
+  std::cout << "PERFORM (first 3):\n";
+  for (std::size_t i = 0; i < std::min<std::size_t>(3, actions.size()); ++i) {
+    actions[i]->perform();
+  }
+
+  // Moving particles a little, most of them stay in their cell
+  std::normal_distribution<double> step{0.0, 0.1};
+  for (std::size_t i = 0; i < positions.size(); ++i) {
+    auto& p = positions[i];
+    p = {p.x + step(generator), p.y + step(generator), p.z + step(generator)};
+    grid.move(static_cast<int>(i), p);
+  }
+  actions = find_scatter_candidates(grid, positions);
+  std::cout << "After moving: " << actions.size()
+            << " candidate(s), brute force: "
+            << count_close_pairs_brute_force(positions, range) << "\n";
+}
@@ -0,0 +1,352 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <span>
+#include <syncstream>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Same actions as in 09_start.cpp, performed by several threads.
+ *
+ *  1) Conflict detection
+ *      ↳ two actions conflict if they share at least one particle id;
+ *      ↳ actions are assigned greedily, in serial order, to "waves": each
+ *        action goes in the wave after the last one that touched any of its
+ *        particles;
+ *      ↳ actions in the same wave are independent, while actions sharing a
+ *        particle end up in different waves, in their serial order.
+ *  2) Work stealing
+ *      ↳ each worker owns a queue of index ranges and pops from its back;
+ *      ↳ a worker splits large ranges and pushes the upper half back to its
+ *        own queue, where idle workers can steal it from the front;
+ *      ↳ waves are run one after the other, i.e. there is a barrier between
+ *        waves.
+ *
+ * The result is the same as the serial loop for every particle, while the
+ * interleaving of independent actions (and of their output) is not
+ * deterministic.
+ */
+
+class Action;
+
+using Particles = std::vector<int>;
+using Actions = std::vector<std::unique_ptr<Action>>;
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    if (const auto& p = particles(); p.size() > 1) {
+      std::osyncstream(std::cout)
+          << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+};
+
+class FluidizationAction : public Action {
+ public:
+  explicit FluidizationAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    if (const auto& p = particles(); p.size() > 0) {
+      std::osyncstream(std::cout) << "Particle " << p.back()
+                                  << " will be melt.\n";
+    }
+  }
+};
+
+// Indices of actions grouped in waves of mutually independent actions
+struct ConflictFreeWaves {
+  std::vector<std::size_t> action_indices{};
+  std::vector<std::size_t> offsets{0};
+
+  std::size_t size() const noexcept { return offsets.size() - 1; }
+};
+
+ConflictFreeWaves build_conflict_free_waves(const Actions& actions) {
+  // wave_of_action[i] = 1 + max(wave of the last action touching a particle)
+  std::vector<std::size_t> wave_of_action(actions.size(), 0);
+  std::unordered_map<int, std::size_t> next_free_wave_of_particle{};
+  std::size_t number_of_waves = 0;
+  for (std::size_t i = 0; i < actions.size(); ++i) {
+    std::size_t wave = 0;
+    for (int id : actions[i]->particles()) {
+      if (auto it = next_free_wave_of_particle.find(id);
+          it != next_free_wave_of_particle.end()) {
+        wave = std::max(wave, it->second);
+      }
+    }
+    for (int id : actions[i]->particles()) {
+      next_free_wave_of_particle[id] = wave + 1;
+    }
+    wave_of_action[i] = wave;
+    number_of_waves = std::max(number_of_waves, wave + 1);
+  }
+  // Counting sort by wave, which keeps the serial order within a wave
+  ConflictFreeWaves waves{};
+  waves.offsets.assign(number_of_waves + 1, 0);
+  for (auto wave : wave_of_action) {
+    ++waves.offsets[wave + 1];
+  }
+  std::partial_sum(waves.offsets.begin(), waves.offsets.end(),
+                   waves.offsets.begin());
+  waves.action_indices.resize(actions.size());
+  auto next_slot = waves.offsets;
+  for (std::size_t i = 0; i < actions.size(); ++i) {
+    waves.action_indices[next_slot[wave_of_action[i]]++] = i;
+  }
+  return waves;
+}
+
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(
+      unsigned number_of_threads = std::thread::hardware_concurrency())
+      : queues_(std::max(number_of_threads, 1u)) {
+    threads_.reserve(queues_.size());
+    for (unsigned id = 0; id < queues_.size(); ++id) {
+      threads_.emplace_back([this, id] { worker_loop(id); });
+    }
+  }
+  // Rule of 5: the pool owns running threads and cannot be copied or moved
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+  WorkStealingPool(WorkStealingPool&&) = delete;
+  WorkStealingPool& operator=(WorkStealingPool&&) = delete;
+  ~WorkStealingPool() {
+    {
+      std::lock_guard lock{mutex_};
+      stop_ = true;
+    }
+    work_available_.notify_all();
+    // Join here: threads_ is declared before the members the workers use
+    // (mutex_, work_available_, ...), which would otherwise be destroyed
+    // first, while woken workers are still re-acquiring mutex_
+    threads_.clear();
+  }
+
+  std::size_t size() const noexcept { return queues_.size(); }
+
+  // Call task(i) for every i in [0, n) and return once all calls are done
+  template <typename F>
+  void parallel_for(std::size_t n, F&& task) {
+    if (n == 0) {
+      return;
+    }
+    grain_ = std::max<std::size_t>(1, n / (8 * queues_.size()));
+    context_ = &task;
+    invoke_ = [](void* context, std::size_t i) {
+      (*static_cast<std::remove_reference_t<F>*>(context))(i);
+    };
+    remaining_.store(n);
+    // Initial distribution, one contiguous chunk per worker
+    const auto chunk = (n + queues_.size() - 1) / queues_.size();
+    for (std::size_t id = 0, begin = 0; begin < n; ++id, begin += chunk) {
+      std::lock_guard lock{queues_[id].mutex};
+      queues_[id].ranges.push_back({begin, std::min(n, begin + chunk)});
+    }
+    {
+      std::lock_guard lock{mutex_};
+      ++generation_;
+    }
+    work_available_.notify_all();
+    std::unique_lock lock{mutex_};
+    all_done_.wait(lock, [this] { return remaining_.load() == 0; });
+  }
+
+ private:
+  struct Range {
+    std::size_t begin, end;
+  };
+
+  // Padded to avoid false sharing between the queues of different workers
+  struct alignas(64) Queue {
+    std::mutex mutex{};
+    std::deque<Range> ranges{};
+  };
+
+  bool try_pop(std::size_t id, Range& range) {
+    auto& queue = queues_[id];
+    std::lock_guard lock{queue.mutex};
+    if (queue.ranges.empty()) {
+      return false;
+    }
+    range = queue.ranges.back();
+    queue.ranges.pop_back();
+    return true;
+  }
+
+  bool try_steal(std::size_t thief, Range& range) {
+    for (std::size_t k = 1; k < queues_.size(); ++k) {
+      auto& queue = queues_[(thief + k) % queues_.size()];
+      std::lock_guard lock{queue.mutex};
+      if (!queue.ranges.empty()) {
+        range = queue.ranges.front();
+        queue.ranges.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void run(std::size_t id, Range range) {
+    // Keep the lower half, expose the upper half to thieves
+    while (range.end - range.begin > grain_) {
+      const auto middle = range.begin + (range.end - range.begin) / 2;
+      {
+        std::lock_guard lock{queues_[id].mutex};
+        queues_[id].ranges.push_back({middle, range.end});
+      }
+      range.end = middle;
+    }
+    for (auto i = range.begin; i < range.end; ++i) {
+      invoke_(context_, i);
+    }
+    const auto count = range.end - range.begin;
+    if (remaining_.fetch_sub(count) == count) {
+      std::lock_guard lock{mutex_};
+      all_done_.notify_all();
+    }
+  }
+
+  void worker_loop(std::size_t id) {
+    std::size_t seen_generation = 0;
+    while (true) {
+      {
+        std::unique_lock lock{mutex_};
+        work_available_.wait(lock, [&] {
+          return stop_ || generation_ != seen_generation;
+        });
+        if (stop_) {
+          return;
+        }
+        seen_generation = generation_;
+      }
+      while (remaining_.load() > 0) {
+        if (Range range{}; try_pop(id, range) || try_steal(id, range)) {
+          run(id, range);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+
+  std::vector<Queue> queues_;
+  std::vector<std::jthread> threads_{};
+  // Current job, type-erased without allocating
+  void (*invoke_)(void*, std::size_t) = nullptr;
+  void* context_ = nullptr;
+  std::size_t grain_ = 1;
+  std::atomic<std::size_t> remaining_{0};
+  // Synchronization between the caller and the workers
+  std::mutex mutex_{};
+  std::condition_variable work_available_{};
+  std::condition_variable all_done_{};
+  std::size_t generation_ = 0;
+  bool stop_ = false;
+};
+
+template <typename F>
+void for_all_actions_in_parallel(const Actions& actions, WorkStealingPool& pool,
+                                 F&& f) {
+  const auto waves = build_conflict_free_waves(actions);
+  for (std::size_t w = 0; w < waves.size(); ++w) {
+    const auto* wave = waves.action_indices.data() + waves.offsets[w];
+    pool.parallel_for(waves.offsets[w + 1] - waves.offsets[w],
+                      [&](std::size_t i) { f(wave[i], *actions[wave[i]]); });
+  }
+}
+
+void perform_all_actions(const Actions& actions) {
+  for (const auto& action : actions) {
+    action->perform();
+  }
+}
+
+void perform_all_actions(const Actions& actions, WorkStealingPool& pool) {
+  for_all_actions_in_parallel(
+      actions, pool, [](std::size_t, const Action& action) { action.perform(); });
+}
+
+int main() {
+  // Creating actions
+  Particles p1 = {1, 11, 111}, p2 = {2, 22, 222}, p3 = {11, 3};
+  Actions actions{};
+  actions.emplace_back(std::make_unique<ScatterAction>(std::move(p1)));
+  actions.emplace_back(std::make_unique<FluidizationAction>(std::move(p2)));
+  actions.emplace_back(std::make_unique<ScatterAction>(std::move(p3)));
+
+  // Performing actions
+  WorkStealingPool pool{4};
+  std::cout << "PERFORM:\n";
+  perform_all_actions(actions, pool);
+
+  // Check on many random actions that each particle sees the same sequence
+  // of actions as in the serial loop
+  constexpr int number_of_particles = 1000;
+  std::mt19937 generator{42};
+  std::uniform_int_distribution<int> random_id{0, number_of_particles - 1};
+  Actions many_actions{};
+  for (int i = 0; i < 100000; ++i) {
+    many_actions.emplace_back(std::make_unique<ScatterAction>(
+        Particles{random_id(generator), random_id(generator)}));
+  }
+  using History = std::vector<std::vector<std::size_t>>;
+  History serial(number_of_particles), parallel(number_of_particles);
+  for (std::size_t i = 0; i < many_actions.size(); ++i) {
+    for (int id : many_actions[i]->particles()) {
+      serial[id].push_back(i);
+    }
+  }
+  for_all_actions_in_parallel(many_actions, pool,
+                              [&](std::size_t i, const Action& action) {
+                                for (int id : action.particles()) {
+                                  parallel[id].push_back(i);
+                                }
+                              });
+  std::cout << "Parallel execution on " << pool.size() << " threads "
+            << (serial == parallel ? "matches" : "DOES NOT match")
+            << " the serial order.\n";
+}
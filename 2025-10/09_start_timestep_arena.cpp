@@ -0,0 +1,176 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+#include <cstddef>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <vector>
+
+/*
+ * Same actions as in 09_start.cpp, created in a per-timestep arena.
+ *
+ *  1) All actions of a timestep and their particles come from one
+ *     std::pmr::monotonic_buffer_resource
+ *      ↳ allocating is a pointer bump into a pre-allocated buffer;
+ *      ↳ deallocating is a no-op;
+ *      ↳ Particles is a std::pmr::vector, and it keeps the arena as its
+ *        allocator when moved into the action.
+ *  2) At the end of the timestep, reset() destroys all actions and releases
+ *     the whole memory at once
+ *      ↳ the initial buffer is reused by the next timestep;
+ *      ↳ only if it is too small, additional chunks are requested from the
+ *        upstream resource (and given back on reset).
+ *  3) Actions must not outlive the reset() of the arena that created them!
+ */
+
+class Action;
+
+using Particles = std::pmr::vector<int>;
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    if (auto p = particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+};
+
+class FluidizationAction : public Action {
+ public:
+  explicit FluidizationAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    if (auto p = particles(); p.size() > 0) {
+      std::cout << "Particle " << p.back() << " will be melt.\n";
+    }
+  }
+};
+
+// Upstream resource counting how often the arena has to fall back on it
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  std::size_t allocations() const noexcept { return allocations_; }
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations_;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::size_t allocations_ = 0;
+};
+
+class TimestepArena {
+ public:
+  using allocator_type = std::pmr::polymorphic_allocator<>;
+  using Actions = std::pmr::vector<Action*>;
+
+  explicit TimestepArena(
+      std::size_t initial_bytes,
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+      : buffer_{std::make_unique<std::byte[]>(initial_bytes)},
+        resource_{buffer_.get(), initial_bytes, upstream} {}
+  // Rule of 5: actions point into the arena, which cannot be copied or moved
+  TimestepArena(const TimestepArena&) = delete;
+  TimestepArena& operator=(const TimestepArena&) = delete;
+  TimestepArena(TimestepArena&&) = delete;
+  TimestepArena& operator=(TimestepArena&&) = delete;
+  ~TimestepArena() { reset(); }
+
+  allocator_type allocator() noexcept { return allocator_type{&resource_}; }
+
+  template <typename T>
+  T& create(std::span<const int> ids) {
+    Particles p{ids.begin(), ids.end(), allocator()};
+    T* action = allocator().new_object<T>(std::move(p));
+    actions_.push_back(action);
+    return *action;
+  }
+
+  template <typename T>
+  T& create(std::initializer_list<int> ids) {
+    return create<T>(std::span<const int>{ids.begin(), ids.size()});
+  }
+
+  const Actions& actions() const noexcept { return actions_; }
+
+  // Destroy all actions and give the whole memory back in one go
+  void reset() {
+    for (Action* action : actions_) {
+      std::destroy_at(action);
+    }
+    actions_ = Actions{allocator()};
+    resource_.release();
+  }
+
+ private:
+  std::unique_ptr<std::byte[]> buffer_;
+  std::pmr::monotonic_buffer_resource resource_;
+  Actions actions_{allocator()};
+};
+
+void perform_all_actions(const TimestepArena::Actions& actions) {
+  for (const auto* action : actions) {
+    action->perform();
+  }
+}
+
+int main() {
+  CountingResource upstream{};
+  TimestepArena arena{1 << 16, &upstream};
+
+  for (int timestep = 0; timestep < 3; ++timestep) {
+    // Creating actions
+    const int offset = 1000 * timestep;
+    arena.create<ScatterAction>({offset + 1, offset + 11, offset + 111});
+    arena.create<FluidizationAction>({offset + 2, offset + 22, offset + 222});
+
+    // Performing actions
+    std::cout << "PERFORM (timestep " << timestep << "):\n";
+    perform_all_actions(arena.actions());
+
+    // Releasing the timestep memory
+    arena.reset();
+  }
+  std::cout << "Upstream allocations: " << upstream.allocations() << "\n";
+}
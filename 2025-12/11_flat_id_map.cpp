@@ -0,0 +1,322 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+/*
+ * A flat hash map from integer ids to values, e.g. from particle ids to the
+ * position of the particle record in a std::vector.
+ *
+ *  1) Open addressing with linear probing
+ *      ↳ all entries live in two arrays, keys and values, no node per entry
+ *        (std::unordered_map allocates a node for each entry and a lookup
+ *        follows at least one pointer to it);
+ *      ↳ a collision is resolved by looking at the next bucket, which is
+ *        most likely in the same cache line;
+ *      ↳ keys are probed without touching the values.
+ *  2) Specialized for int keys
+ *      ↳ one key value is reserved to mark empty buckets, inserting it throws
+ *        and looking it up never finds anything;
+ *      ↳ the capacity is a power of two and the bucket is found by
+ *        multiplicative (Fibonacci) hashing, no modulo operation needed.
+ *  3) Erasing shifts the following entries back, no tombstones are left
+ *      ↳ probe sequences stay as short as if the entry had never been there.
+ *  4) Bulk operations
+ *      ↳ find_all(ids, out) looks up a whole span of ids, first computing
+ *        all buckets and prefetching them, then probing;
+ *      ↳ rebuild(keys, values) replaces all content, allocating at most once.
+ *
+ * WANNA DIG MORE?
+ *  -> CppCon 2017: Matt Kulukundis “Designing a Fast, Efficient,
+ *         Cache-friendly Hash Table, Step by Step”
+ *         https://www.youtube.com/watch?v=ncHmEUmJZf4
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+template <typename V>
+class FlatIdMap {
+ public:
+  using key_type = int;
+  using mapped_type = V;
+  using size_type = std::size_t;
+
+  // This key cannot be stored, it marks empty buckets
+  static constexpr key_type empty_key = std::numeric_limits<int>::min();
+
+  FlatIdMap() = default;
+  explicit FlatIdMap(size_type expected_size) { reserve(expected_size); }
+
+  // Return true if the key was inserted, false if it was already there
+  bool insert_or_assign(key_type key, V value) {
+    check_key(key);
+    if ((size_ + 1) * max_load_denominator > capacity() * max_load_numerator) {
+      grow_to(std::max<size_type>(2 * capacity(), minimum_capacity));
+    }
+    const auto bucket = probe(key);
+    values_[bucket] = std::move(value);
+    if (keys_[bucket] == key) {
+      return false;
+    }
+    keys_[bucket] = key;
+    ++size_;
+    return true;
+  }
+
+  // Pointer to the value, or nullptr if the key is not in the map
+  V* find(key_type key) noexcept {
+    if (size_ == 0 || key == empty_key) {
+      return nullptr;
+    }
+    const auto bucket = probe(key);
+    return keys_[bucket] == key ? &values_[bucket] : nullptr;
+  }
+  const V* find(key_type key) const noexcept {
+    return const_cast<FlatIdMap*>(this)->find(key);
+  }
+
+  bool contains(key_type key) const noexcept { return find(key) != nullptr; }
+
+  // Look up all ids at once, missing ones get the not_found value
+  // Return how many ids were found
+  size_type find_all(std::span<const int> ids, std::span<V> out,
+                     const V& not_found = V{}) const {
+    assert(out.size() >= ids.size());
+    if (size_ == 0) {
+      std::fill_n(out.begin(), ids.size(), not_found);
+      return 0;
+    }
+    constexpr size_type chunk = 16;
+    size_type buckets[chunk];
+    size_type found = 0;
+    for (size_type begin = 0; begin < ids.size(); begin += chunk) {
+      const auto end = std::min(begin + chunk, ids.size());
+      // Independent loads first, to overlap their cache misses
+      for (auto i = begin; i < end; ++i) {
+        buckets[i - begin] = home(ids[i]);
+#if defined(__GNUC__)
+        __builtin_prefetch(&keys_[buckets[i - begin]]);
+#endif
+      }
+      for (auto i = begin; i < end; ++i) {
+        // Probing for the empty key would stop at, and match, an empty bucket
+        if (ids[i] == empty_key) {
+          out[i] = not_found;
+          continue;
+        }
+        auto bucket = buckets[i - begin];
+        while (keys_[bucket] != ids[i] && keys_[bucket] != empty_key) {
+          bucket = (bucket + 1) & mask_;
+        }
+        if (keys_[bucket] == ids[i]) {
+          out[i] = values_[bucket];
+          ++found;
+        } else {
+          out[i] = not_found;
+        }
+      }
+    }
+    return found;
+  }
+
+  // Return true if the key was erased, false if it was not in the map
+  bool erase(key_type key) {
+    if (size_ == 0 || key == empty_key) {
+      return false;
+    }
+    auto hole = probe(key);
+    if (keys_[hole] != key) {
+      return false;
+    }
+    // Move back following entries, unless they are already at their home
+    // bucket or between it and the hole
+    for (auto next = (hole + 1) & mask_; keys_[next] != empty_key;
+         next = (next + 1) & mask_) {
+      const auto from_home = (next - home(keys_[next])) & mask_;
+      const auto from_hole = (next - hole) & mask_;
+      if (from_home >= from_hole) {
+        keys_[hole] = keys_[next];
+        values_[hole] = std::move(values_[next]);
+        hole = next;
+      }
+    }
+    keys_[hole] = empty_key;
+    values_[hole] = V{};
+    --size_;
+    return true;
+  }
+
+  // Replace all content, keys must be unique
+  void rebuild(std::span<const int> keys, std::span<const V> values) {
+    assert(keys.size() == values.size());
+    std::for_each(keys.begin(), keys.end(), check_key);
+    clear();
+    reserve(keys.size());
+    for (size_type i = 0; i < keys.size(); ++i) {
+      const auto bucket = probe(keys[i]);
+      assert(keys_[bucket] == empty_key);
+      keys_[bucket] = keys[i];
+      values_[bucket] = values[i];
+    }
+    size_ = keys.size();
+  }
+
+  void reserve(size_type n) {
+    const auto needed = n * max_load_denominator / max_load_numerator + 1;
+    if (needed > capacity()) {
+      grow_to(std::bit_ceil(std::max(needed, minimum_capacity)));
+    }
+  }
+
+  void clear() noexcept {
+    std::fill(keys_.begin(), keys_.end(), empty_key);
+    std::fill(values_.begin(), values_.end(), V{});
+    size_ = 0;
+  }
+
+  size_type size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0; }
+  size_type capacity() const noexcept { return keys_.size(); }
+
+ private:
+  static constexpr size_type minimum_capacity = 16;
+  // At most 3/4 of the buckets are in use
+  static constexpr size_type max_load_numerator = 3;
+  static constexpr size_type max_load_denominator = 4;
+
+  static void check_key(key_type key) {
+    if (key == empty_key) {
+      throw std::invalid_argument{"FlatIdMap cannot store its empty key"};
+    }
+  }
+
+  size_type home(key_type key) const noexcept {
+    constexpr std::uint64_t golden_ratio = 0x9E3779B97F4A7C15ull;
+    const auto hash =
+        static_cast<std::uint64_t>(static_cast<std::uint32_t>(key)) *
+        golden_ratio;
+    return static_cast<size_type>(hash >> shift_);
+  }
+
+  // Bucket holding the key or, if absent, the empty bucket ending its probe
+  size_type probe(key_type key) const noexcept {
+    auto bucket = home(key);
+    while (keys_[bucket] != key && keys_[bucket] != empty_key) {
+      bucket = (bucket + 1) & mask_;
+    }
+    return bucket;
+  }
+
+  void grow_to(size_type new_capacity) {
+    assert(std::has_single_bit(new_capacity));
+    auto old_keys =
+        std::exchange(keys_, std::vector<int>(new_capacity, empty_key));
+    auto old_values = std::exchange(values_, std::vector<V>(new_capacity));
+    mask_ = new_capacity - 1;
+    shift_ = 64 - std::countr_zero(new_capacity);
+    for (size_type i = 0; i < old_keys.size(); ++i) {
+      if (old_keys[i] != empty_key) {
+        const auto bucket = probe(old_keys[i]);
+        keys_[bucket] = old_keys[i];
+        values_[bucket] = std::move(old_values[i]);
+      }
+    }
+  }
+
+  std::vector<int> keys_{};
+  std::vector<V> values_{};
+  size_type size_ = 0;
+  size_type mask_ = 0;
+  int shift_ = 64;
+};
+
+//=========================== ACTIONS EXAMPLE =================================
+
+struct ParticleRecord {
+  int id;
+  double energy;
+};
+
+using ParticleSlot = std::uint32_t;
+using ParticleIndex = FlatIdMap<ParticleSlot>;
+
+// The index from particle ids to records is rebuilt when records are reordered
+void rebuild_index(ParticleIndex& index,
+                   std::span<const ParticleRecord> records) {
+  std::vector<int> ids(records.size());
+  std::vector<ParticleSlot> slots(records.size());
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    ids[i] = records[i].id;
+    slots[i] = static_cast<ParticleSlot>(i);
+  }
+  index.rebuild(ids, slots);
+}
+
+constexpr ParticleSlot no_slot = std::numeric_limits<ParticleSlot>::max();
+
+int main() {
+  // Particle records, identified by sparse ids
+  std::vector<ParticleRecord> records{};
+  for (int i = 0; i < 1000; ++i) {
+    records.push_back({7919 * i + 13, 0.5 * i});
+  }
+  ParticleIndex index{};
+  rebuild_index(index, records);
+
+  // Resolving the particles of an action in one go
+  const std::vector<int> particles = {
+      13, 7932, 15851, 42, 7919 * 999 + 13, ParticleIndex::empty_key};
+  std::vector<ParticleSlot> slots(particles.size());
+  const auto found = index.find_all(particles, slots, no_slot);
+  std::cout << "Found " << found << " out of " << particles.size()
+            << " particles:\n";
+  for (std::size_t i = 0; i < particles.size(); ++i) {
+    std::cout << "  " << particles[i] << " -> ";
+    if (slots[i] == no_slot) {
+      std::cout << "not found\n";
+    } else {
+      std::cout << "energy " << records[slots[i]].energy << "\n";
+    }
+  }
+
+  // Erasing half of the particles, and checking against std::unordered_map
+  std::unordered_map<int, ParticleSlot> reference{};
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    reference.emplace(records[i].id, static_cast<ParticleSlot>(i));
+  }
+  for (std::size_t i = 0; i < records.size(); i += 2) {
+    index.erase(records[i].id);
+    reference.erase(records[i].id);
+  }
+  // The empty key is never found, nor erased
+  const auto size = index.size();
+  bool same = !index.contains(ParticleIndex::empty_key) &&
+              !index.erase(ParticleIndex::empty_key) && index.size() == size;
+  same = same && index.size() == reference.size();
+  for (const auto& record : records) {
+    const auto* slot = index.find(record.id);
+    const auto it = reference.find(record.id);
+    same = same && (slot == nullptr) == (it == reference.end()) &&
+           (slot == nullptr || *slot == it->second);
+  }
+  std::cout << "After erasing, " << index.size() << " particles left, "
+            << (same ? "same as" : "DIFFERENT FROM")
+            << " std::unordered_map.\n";
+}
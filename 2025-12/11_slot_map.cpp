@@ -0,0 +1,260 @@
+/*
+ *===================================================
+ *
+ *    Copyright (c) 2025
+ *      Alessandro Sciarra
+ *
+ *    GNU General Public License (GPLv3 or later)
+ *
+ *===================================================
+ */
+
+/*
+ * A slot map: a container with stable handles and contiguous storage.
+ *
+ *  1) Elements are stored densely in a std::vector
+ *      ↳ iteration is a linear walk in memory, as for std::vector;
+ *      ↳ erase moves the last element into the hole (order is not kept).
+ *  2) Handles give access to elements, instead of pointers or indices
+ *      ↳ a handle is an index into a table of slots plus a generation;
+ *      ↳ a slot points to the position of its element in the dense storage;
+ *      ↳ erasing an element bumps the generation of its slot, hence any old
+ *        handle to it is detected as invalid (no dangling references);
+ *      ↳ free slots are recycled through an intrusive free list;
+ *      ↳ generations start at 1, so a default-constructed handle is null.
+ *  3) Complexity
+ *      ↳ insert, erase and lookup by handle are O(1);
+ *      ↳ handles remain valid across insertions and erasures of other
+ *        elements, while iterators and references into the dense storage do
+ *        not (same rules as for std::vector).
+ *
+ * WANNA DIG MORE?
+ *  -> CppCon 2017: Allan Deutsch “The Slot Map Data Structure”
+ *         https://www.youtube.com/watch?v=SHaAR7XPtNU
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+// The default handle refers to nothing, generation 0 is never used
+struct SlotMapHandle {
+  std::uint32_t index = 0;
+  std::uint32_t generation = 0;
+
+  bool operator==(const SlotMapHandle&) const = default;
+};
+
+template <typename T>
+class SlotMap {
+ public:
+  using value_type = T;
+  using reference = T&;
+  using const_reference = const T&;
+  using size_type = std::size_t;
+  using handle = SlotMapHandle;
+  using iterator = typename std::vector<T>::iterator;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  // Room is made in all containers first, so that nothing can throw once the
+  // element is constructed and they always agree
+  template <typename... Args>
+  handle emplace(Args&&... args) {
+    make_room_for_one_more(slot_of_data_);
+    if (free_head_ == end_of_free_list) {
+      make_room_for_one_more(slots_);
+    }
+    data_.emplace_back(std::forward<Args>(args)...);
+    std::uint32_t index;
+    if (free_head_ != end_of_free_list) {
+      index = free_head_;
+      free_head_ = slots_[index].position;
+    } else {
+      index = static_cast<std::uint32_t>(slots_.size());
+      slots_.push_back({});
+    }
+    slots_[index].position = static_cast<std::uint32_t>(data_.size() - 1);
+    slot_of_data_.push_back(index);
+    return {index, slots_[index].generation};
+  }
+
+  handle insert(T value) { return emplace(std::move(value)); }
+
+  // Erase the element the handle refers to, return false if it was invalid
+  bool erase(handle h) {
+    if (!contains(h)) {
+      return false;
+    }
+    auto& slot = slots_[h.index];
+    const auto position = slot.position;
+    const auto last = static_cast<std::uint32_t>(data_.size() - 1);
+    if (position != last) {
+      data_[position] = std::move(data_[last]);
+      slot_of_data_[position] = slot_of_data_[last];
+      slots_[slot_of_data_[position]].position = position;
+    }
+    data_.pop_back();
+    slot_of_data_.pop_back();
+    if (++slot.generation == 0) {
+      slot.generation = 1;
+    }
+    slot.position = free_head_;
+    free_head_ = h.index;
+    return true;
+  }
+
+  bool contains(handle h) const noexcept {
+    return h.index < slots_.size() &&
+           slots_[h.index].generation == h.generation;
+  }
+
+  // Pointer to the element, or nullptr if the handle is not valid anymore
+  T* find(handle h) noexcept {
+    return contains(h) ? &data_[slots_[h.index].position] : nullptr;
+  }
+  const T* find(handle h) const noexcept {
+    return contains(h) ? &data_[slots_[h.index].position] : nullptr;
+  }
+
+  reference operator[](handle h) {
+    assert(contains(h));
+    return data_[slots_[h.index].position];
+  }
+  const_reference operator[](handle h) const {
+    assert(contains(h));
+    return data_[slots_[h.index].position];
+  }
+
+  // Handle of the element at the given position in the dense storage
+  handle handle_at(size_type position) const {
+    const auto index = slot_of_data_[position];
+    return {index, slots_[index].generation};
+  }
+
+  void reserve(size_type n) {
+    data_.reserve(n);
+    slot_of_data_.reserve(n);
+    slots_.reserve(n);
+  }
+
+  size_type size() const noexcept { return data_.size(); }
+  bool empty() const noexcept { return data_.empty(); }
+
+  iterator begin() noexcept { return data_.begin(); }
+  iterator end() noexcept { return data_.end(); }
+  const_iterator begin() const noexcept { return data_.begin(); }
+  const_iterator end() const noexcept { return data_.end(); }
+
+ private:
+  static constexpr std::uint32_t end_of_free_list = UINT32_MAX;
+
+  template <typename V>
+  static void make_room_for_one_more(V& v) {
+    if (v.size() == v.capacity()) {
+      v.reserve(std::max<size_type>(1, 2 * v.capacity()));
+    }
+  }
+
+  // If the slot is free, position is the index of the next free slot
+  struct Slot {
+    std::uint32_t position = 0;
+    std::uint32_t generation = 1;
+  };
+
+  std::vector<T> data_{};
+  std::vector<std::uint32_t> slot_of_data_{};
+  std::vector<Slot> slots_{};
+  std::uint32_t free_head_ = end_of_free_list;
+};
+
+//=========================== ACTIONS EXAMPLE =================================
+
+class Action;
+
+using Particles = std::vector<int>;
+using ActionHandle = SlotMapHandle;
+using Actions = SlotMap<std::unique_ptr<Action>>;
+
+class Action {
+ public:
+  // Rule of 5: Action cannot be copied or moved
+  explicit Action(Particles p) : particles_{std::move(p)} {};
+  Action(const Action&) = delete;
+  Action& operator=(const Action&) = delete;
+  Action(Action&&) = delete;
+  Action& operator=(Action&&) = delete;
+  // Virtual destructor for polymorphism
+  virtual ~Action() = default;
+
+  // External read-access to particles
+  std::span<const int> particles() const { return particles_; }
+
+  // Operations
+  virtual void perform() const = 0;
+
+ private:
+  Particles particles_;
+};
+
+class ScatterAction : public Action {
+ public:
+  explicit ScatterAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    if (auto p = particles(); p.size() > 1) {
+      std::cout << "Scattering between " << p[0] << " and " << p[1] << ".\n";
+    }
+  }
+};
+
+class FluidizationAction : public Action {
+ public:
+  explicit FluidizationAction(Particles p) : Action{std::move(p)} {}
+  void perform() const override {
+    if (auto p = particles(); p.size() > 0) {
+      std::cout << "Particle " << p.back() << " will be melt.\n";
+    }
+  }
+};
+
+void perform_all_actions(const Actions& actions) {
+  for (const auto& action : actions) {
+    action->perform();
+  }
+}
+
+int main() {
+  // Creating actions, e.g. a scheduler could keep the handles
+  Actions actions{};
+  const ActionHandle h1 = actions.insert(
+      std::make_unique<ScatterAction>(Particles{1, 11, 111}));
+  const ActionHandle h2 = actions.insert(
+      std::make_unique<FluidizationAction>(Particles{2, 22, 222}));
+  const ActionHandle h3 = actions.insert(
+      std::make_unique<ScatterAction>(Particles{3, 33, 333}));
+
+  std::cout << "PERFORM:\n";
+  perform_all_actions(actions);
+
+  // Erasing from the middle does not invalidate the other handles
+  actions.erase(h1);
+  const ActionHandle h4 = actions.insert(
+      std::make_unique<FluidizationAction>(Particles{4, 44, 444}));
+  std::cout << "PERFORM after erasing the first action:\n";
+  perform_all_actions(actions);
+
+  std::cout << std::boolalpha << "h1 valid: " << actions.contains(h1)
+            << ", h2 valid: " << actions.contains(h2)
+            << ", h3 valid: " << actions.contains(h3)
+            << ", h4 reuses the slot of h1: " << (h4.index == h1.index)
+            << "\n";
+  std::cout << "Via h3: ";
+  actions[h3]->perform();
+  std::cout << "Default handle refers to nothing: "
+            << (actions.find(ActionHandle{}) == nullptr) << "\n";
+}